@@ -0,0 +1,49 @@
+/**
+ * File: alias.cc
+ * --------------
+ * Provides the implementation of buildAliasTable.
+ */
+
+#include "alias.h"
+
+/**
+ * Each weight is scaled so that the average column holds exactly 1.
+ * Columns holding less than 1 are topped up from a column holding more
+ * than 1, which becomes their alias, until every column is full.
+ * Whatever is left over (including rounding error) is a full column.
+ */
+
+void buildAliasTable(const vector<double>& weights, vector<uint32_t>& thresholds,
+                     vector<int32_t>& aliases)
+{
+  int count = weights.size();
+  thresholds.assign(count, 0);
+  aliases.resize(count);
+  for (int i = 0; i < count; i++) aliases[i] = i;
+
+  double total = 0;
+  for (int i = 0; i < count; i++) total += weights[i];
+  if (total <= 0) return; // uniform: every column keeps itself
+
+  vector<double> scaled(count);
+  vector<int> small, large;
+  for (int i = 0; i < count; i++) {
+    scaled[i] = weights[i] * count / total;
+    if (scaled[i] < 1.0) small.push_back(i);
+    else large.push_back(i);
+  }
+
+  while (!small.empty() && !large.empty()) {
+    int lesser = small.back();
+    small.pop_back();
+    int greater = large.back();
+    double threshold = scaled[lesser] * 4294967296.0;
+    thresholds[lesser] = threshold >= 4294967295.0 ? 4294967295u : (uint32_t) threshold;
+    aliases[lesser] = greater;
+    scaled[greater] -= 1.0 - scaled[lesser];
+    if (scaled[greater] < 1.0) {
+      large.pop_back();
+      small.push_back(greater);
+    }
+  }
+}
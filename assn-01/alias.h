@@ -0,0 +1,36 @@
+/**
+ * File: alias.h
+ * -------------
+ * Defines the interface to Walker's alias method, which turns
+ * an arbitrary discrete distribution into a table that can be
+ * sampled in constant time: pick a column uniformly at random,
+ * then flip one biased coin to decide between the column itself
+ * and the column's alias.
+ */
+
+#ifndef __alias__
+#define __alias__
+
+#include <vector>
+#include <stdint.h>
+using namespace std;
+
+/**
+ * Function: buildAliasTable
+ * -------------------------
+ * Builds the alias table for the specified weights using Vose's
+ * linear-time construction.  Column i keeps itself with probability
+ * thresholds[i] / 2^32 and otherwise yields aliases[i].  A column that
+ * always keeps itself has aliases[i] == i, so callers can skip the coin
+ * flip entirely for it, and for every column of a uniform distribution.
+ *
+ * @param weights the relative weights, which must be non-negative.  If
+ *                they're all zero, the distribution is taken to be uniform.
+ * @param thresholds cleared and filled with one threshold per weight.
+ * @param aliases cleared and filled with one alias per weight.
+ */
+
+void buildAliasTable(const vector<double>& weights, vector<uint32_t>& thresholds,
+                     vector<int32_t>& aliases);
+
+#endif // ! __alias__
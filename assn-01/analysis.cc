@@ -0,0 +1,680 @@
+/**
+ * File: analysis.cc
+ * -----------------
+ * Provides the implementation of the GrammarAnalysis class.  The
+ * grammar is first flattened into an indexed form in which each
+ * production knows its probability, how many terminals (and terminal
+ * bytes) it contributes directly, and which nonterminals it expands.
+ *
+ * The nonterminals are then split into the strongly connected
+ * components of the graph in which each one points to the ones it can
+ * expand into, and the components are solved in reverse topological
+ * order, so that everything a component expands into is known by the
+ * time it's reached.  A nonterminal that's on no cycle is solved
+ * exactly in one step; only the members of a cycle are iterated, and
+ * only among themselves.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <unordered_map>
+#include "analysis.h"
+#include "grammar.h"
+
+/**
+ * No component is iterated more than this many rounds, and the depth
+ * statistics are followed for no more than this many levels.  Whatever
+ * is still moving by then is taken to diverge.
+ */
+
+static const int kMaxIterations = 10000;
+static const double kTolerance = 1e-12;
+static const double kInfinity = numeric_limits<double>::infinity();
+
+/**
+ * A cyclic component whose expansions multiply at a rate within this
+ * much of 1 is taken to be critical: its expected length is infinite,
+ * even though its expansions all finish (unless something they expand
+ * into might not).
+ */
+
+static const double kCriticalSlack = 1e-9;
+
+/**
+ * Struct: rule
+ * ------------
+ * One production, as far as the analysis is concerned.
+ */
+
+struct rule {
+  double probability;
+  double tokens;         // terminals appearing directly in the production
+  double bytes;          // their text, plus one separator apiece
+  vector<int> children;  // nonterminals appearing in the production
+};
+
+/**
+ * How fast the expansions within a cyclic component multiply: the
+ * spectral radius of the matrix of expected expansion counts
+ * is below 1, within kCriticalSlack of it, or above it.
+ */
+
+enum growthRate { kSubcritical, kCritical, kSupercritical, kUndetermined };
+
+/**
+ * Returns true if the new estimate differs meaningfully from the old.
+ */
+
+static bool hasMoved(double previous, double current)
+{
+  if (current == previous) return false;
+  return fabs(current - previous) > kTolerance * max(1.0, fabs(current));
+}
+
+/**
+ * Finds the strongly connected components of the graph in which every
+ * nonterminal points to its successors, using Tarjan's algorithm with
+ * an explicit stack, so that long chains of definitions can't overflow
+ * the call stack.  Each component is listed after every component it
+ * points into, which is the order in which they can be solved.
+ */
+
+static void findComponents(const vector<vector<int> >& successors, vector<vector<int> >& components)
+{
+  int count = successors.size();
+  vector<int> order(count, -1), lowest(count), stack;
+  vector<bool> onStack(count, false);
+  vector<pair<int, size_t> > calls;   // a nonterminal, and the next of its successors to visit
+  int visited = 0;
+  for (int root = 0; root < count; root++) {
+    if (order[root] != -1) continue;
+    order[root] = lowest[root] = visited++;
+    stack.push_back(root);
+    onStack[root] = true;
+    calls.push_back(make_pair(root, 0));
+    while (!calls.empty()) {
+      int curr = calls.back().first;
+      if (calls.back().second < successors[curr].size()) {
+        int child = successors[curr][calls.back().second++];
+        if (order[child] == -1) {
+          order[child] = lowest[child] = visited++;
+          stack.push_back(child);
+          onStack[child] = true;
+          calls.push_back(make_pair(child, 0));
+        } else if (onStack[child]) {
+          lowest[curr] = min(lowest[curr], order[child]);
+        }
+        continue;
+      }
+
+      calls.pop_back();
+      if (!calls.empty()) lowest[calls.back().first] = min(lowest[calls.back().first], lowest[curr]);
+      if (lowest[curr] != order[curr]) continue;
+      components.push_back(vector<int>());
+      int member;
+      do {
+        member = stack.back();
+        stack.pop_back();
+        onStack[member] = false;
+        components.back().push_back(member);
+      } while (member != curr);
+    }
+  }
+}
+
+/**
+ * Sets result to (v + Mv) / 2, where M holds the expected number of
+ * times each member of a component expands each other member.  The
+ * members are listed in members, and position maps every nonterminal
+ * to its place in that list, or to -1 if it's not a member.  Averaging
+ * with v changes none of M's eigenvectors, but keeps the iterates from
+ * oscillating when the component's cycles all have a common length.
+ */
+
+static void expandWithin(const vector<vector<rule> >& rules, const vector<int>& members,
+                         const vector<int>& position, const vector<double>& v, vector<double>& result)
+{
+  for (size_t m = 0; m < members.size(); m++) {
+    const vector<rule>& productions = rules[members[m]];
+    double total = 0;
+    for (size_t r = 0; r < productions.size(); r++) {
+      double sum = 0;
+      for (size_t c = 0; c < productions[r].children.size(); c++)
+        if (position[productions[r].children[c]] != -1) sum += v[position[productions[r].children[c]]];
+      total += productions[r].probability * sum;
+    }
+    result[m] = (v[m] + total) / 2;
+  }
+}
+
+/**
+ * Sets lower and upper to the least and greatest of after[i] / before[i],
+ * where after is the result of expandWithin on before.  Since M is
+ * irreducible within a component, they bound the rate at which the
+ * iterates grow (and always will), whatever before was.
+ */
+
+static void boundGrowth(const vector<double>& before, const vector<double>& after, double& lower, double& upper)
+{
+  lower = kInfinity;
+  upper = 0;
+  for (size_t i = 0; i < before.size(); i++) {
+    if (before[i] > 0) {
+      lower = min(lower, after[i] / before[i]);
+      upper = max(upper, after[i] / before[i]);
+    } else if (after[i] > 0) {
+      upper = kInfinity;
+    }
+  }
+  if (lower == kInfinity) lower = 0;
+}
+
+/**
+ * Classifies the growth rate of a cyclic component by power iteration
+ * from the all-ones vector, stopping as soon as the bounds settle the
+ * question.  The bounds apply to (1 + r) / 2 rather than r itself.
+ */
+
+static growthRate classifyGrowth(const vector<vector<rule> >& rules, const vector<int>& members,
+                                 const vector<int>& position)
+{
+  vector<double> v(members.size(), 1.0), next(members.size());
+  for (int iteration = 0; iteration < kMaxIterations; iteration++) {
+    expandWithin(rules, members, position, v, next);
+    double lower, upper;
+    boundGrowth(v, next, lower, upper);
+    if (upper < 1 - kCriticalSlack) return kSubcritical;
+    if (lower > 1 + kCriticalSlack) return kSupercritical;
+    if (lower >= 1 - kCriticalSlack && upper <= 1 + kCriticalSlack) return kCritical;
+    double largest = *max_element(next.begin(), next.end());
+    for (size_t m = 0; m < v.size(); m++) v[m] = next[m] / largest;
+  }
+  return kUndetermined;
+}
+
+/**
+ * Sets x to the least solution of x = b + Mx for a cyclic component,
+ * which is b + Mb + M²b + ..., and returns false if the sum diverges
+ * (or can't be pinned down).  The series is summed with (I + M) / 2 in
+ * place of M, which doubles it.  Once the growth bounds of its terms
+ * fall below 1, they bound what the rest of the series can add, and
+ * the sum stops as soon as those bounds agree.
+ */
+
+static bool sumSeries(const vector<vector<rule> >& rules, const vector<int>& members,
+                      const vector<int>& position, const vector<double>& b, vector<double>& x)
+{
+  vector<double> term(b), next(b.size()), sum(b);
+  for (int iteration = 0; iteration < kMaxIterations; iteration++) {
+    expandWithin(rules, members, position, term, next);
+    double lower, upper;
+    boundGrowth(term, next, lower, upper);
+    term.swap(next);
+    for (size_t m = 0; m < sum.size(); m++) sum[m] += term[m];
+    if (lower >= 1 - kCriticalSlack) return false;
+    if (upper >= 1) continue;
+    double least = lower / (1 - lower), most = upper / (1 - upper);
+    bool settled = true;
+    for (size_t m = 0; m < sum.size() && settled; m++)
+      settled = (most - least) * term[m] <= kTolerance * (sum[m] + least * term[m]);
+    if (!settled) continue;
+    for (size_t m = 0; m < sum.size(); m++) x[m] = (sum[m] + (least + most) / 2 * term[m]) / 2;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Computes, for the members of one component, the expected value of
+ * some additive quantity (the number of terminals, say) over a random
+ * expansion, given the expectations of every component below it.  The
+ * quantity contributed directly by each rule is selected by field.  What
+ * each member gets from its own terminals and from other components
+ * is exact; within a cycle, the rest is the sum of a series that's
+ * finite only if the component is subcritical.
+ */
+
+static void solveExpectations(const vector<vector<rule> >& rules, double rule::*field,
+                              const vector<int>& members, const vector<int>& position,
+                              bool cyclic, growthRate growth, vector<double>& expected)
+{
+  vector<double> direct(members.size(), 0.0);
+  bool infinite = false, positive = false;
+  for (size_t m = 0; m < members.size(); m++) {
+    const vector<rule>& productions = rules[members[m]];
+    for (size_t r = 0; r < productions.size(); r++) {
+      if (productions[r].probability == 0) continue;
+      double total = productions[r].*field;
+      for (size_t c = 0; c < productions[r].children.size(); c++)
+        if (position[productions[r].children[c]] == -1) total += expected[productions[r].children[c]];
+      direct[m] += productions[r].probability * total;
+    }
+    if (isinf(direct[m])) infinite = true;
+    if (direct[m] > 0) positive = true;
+  }
+
+  if (!cyclic) {
+    expected[members[0]] = direct[0];
+    return;
+  }
+
+  vector<double> solution(members.size(), 0.0);
+  if (infinite || (positive && (growth == kCritical || growth == kSupercritical)) ||
+      (positive && !sumSeries(rules, members, position, direct, solution)))
+    solution.assign(members.size(), kInfinity);
+  for (size_t m = 0; m < members.size(); m++) expected[members[m]] = solution[m];
+}
+
+/**
+ * Returns the probability that one random expansion of a rule from the
+ * specified list finishes, given the probability of that for each of
+ * the nonterminals.  Members of the component listed by position are
+ * looked up in within instead, unless within is NULL.
+ */
+
+static double finishProbability(const vector<rule>& productions, const vector<double>& finished,
+                                const vector<int>& position, const vector<double> *within)
+{
+  double value = 0;
+  for (size_t r = 0; r < productions.size(); r++) {
+    if (productions[r].probability == 0) continue;
+    double product = productions[r].probability;
+    for (size_t c = 0; c < productions[r].children.size(); c++) {
+      int child = productions[r].children[c];
+      product *= within != NULL && position[child] != -1 ? (*within)[position[child]] : finished[child];
+    }
+    value += product;
+  }
+  return value;
+}
+
+/**
+ * Computes the probability that a random expansion of each member of
+ * one component terminates, given the same for every component below
+ * it.  That's the least solution of a system of polynomial equations,
+ * which iteration from zero converges to quickly unless the component
+ * is critical, in which case it creeps toward 1 forever; that case is
+ * recognized up front and answered directly.  Returns true if the
+ * iteration settled, and false if the component is critical (or gave
+ * up), so that its depth can't be expected to be finite.
+ */
+
+static bool solveTermination(const vector<vector<rule> >& rules, const vector<int>& members,
+                             const vector<int>& position, bool cyclic, growthRate growth,
+                             vector<double>& termination)
+{
+  if (!cyclic) {
+    termination[members[0]] = finishProbability(rules[members[0]], termination, position, NULL);
+    return true;
+  }
+
+  // critical growth only means certain termination if nothing leaks out to
+  // components that might not terminate, and if the component isn't just a
+  // single line of descent (each rule expanding exactly one member), which
+  // goes on forever.
+  if (growth == kCritical) {
+    vector<double> ones(members.size(), 1.0);
+    bool exitsCertain = true, singular = true;
+    for (size_t m = 0; m < members.size(); m++) {
+      const vector<rule>& productions = rules[members[m]];
+      if (finishProbability(productions, termination, position, &ones) < 1 - kTolerance) exitsCertain = false;
+      for (size_t r = 0; r < productions.size() && singular; r++) {
+        if (productions[r].probability == 0) continue;
+        int inside = 0;
+        for (size_t c = 0; c < productions[r].children.size(); c++)
+          if (position[productions[r].children[c]] != -1) inside++;
+        singular = inside == 1;
+      }
+    }
+    if (exitsCertain && !singular) {
+      for (size_t m = 0; m < members.size(); m++) termination[members[m]] = 1.0;
+      return false;
+    }
+  }
+
+  vector<double> current(members.size(), 0.0), next(members.size());
+  bool moving = true;
+  for (int iteration = 0; iteration < kMaxIterations && moving; iteration++) {
+    moving = false;
+    for (size_t m = 0; m < members.size(); m++) {
+      next[m] = finishProbability(rules[members[m]], termination, position, &current);
+      if (hasMoved(current[m], next[m])) moving = true;
+    }
+    current.swap(next);
+  }
+  for (size_t m = 0; m < members.size(); m++) termination[members[m]] = current[m];
+  return !moving;
+}
+
+/**
+ * Sets the expected depth in every report, and returns the probability
+ * that expanding the start symbol (if start isn't -1) either never
+ * terminates or goes deeper than maxDepth.
+ *
+ * finished[i] is the probability that nonterminal i finishes within
+ * the current number of levels, so its limit is the probability of
+ * terminating at all, and the running sum of finished[i] over the levels
+ * is all that's needed to recover the expected depth.  Each level
+ * revisits only the nonterminals with a child that moved on the last one,
+ * and a nonterminal's sum is brought up to date only when it's revisited.
+ * Unsettled nonterminals never stop moving, so they're followed only as
+ * far as the depth limit (and only if they're reachable), and from then
+ * on they hold the limits already computed for them.
+ */
+
+static double measureDepths(const vector<vector<rule> >& rules, const vector<vector<int> >& predecessors,
+                            const vector<double>& termination, vector<bool> unsettled, int start, int maxDepth,
+                            vector<GrammarAnalysis::nonterminalReport>& reports)
+{
+  int count = rules.size();
+  double depthLimitProbability = 1.0;
+  vector<double> finished(count, 0.0), sumFinished(count, 0.0), values;
+  vector<int> updated(count, 0), active, next, none;
+  vector<bool> queued(count, false), frozen(count, false);
+  for (int i = 0; i < count; i++) {
+    frozen[i] = unsettled[i] && !reports[i].reachable;
+    if (frozen[i]) finished[i] = termination[i];
+    else active.push_back(i);
+  }
+  int levels = 0;
+  while (!active.empty() && levels < kMaxIterations) {
+    values.resize(active.size());
+    for (size_t a = 0; a < active.size(); a++)
+      values[a] = finishProbability(rules[active[a]], finished, none, NULL);
+    levels++;
+    next.clear();
+    for (size_t a = 0; a < active.size(); a++) {
+      int i = active[a];
+      bool moved = hasMoved(finished[i], values[a]);
+      sumFinished[i] += finished[i] * (levels - updated[i]);
+      finished[i] = values[a];
+      updated[i] = levels;
+      for (size_t p = 0; moved && p < predecessors[i].size(); p++) {
+        int user = predecessors[i][p];
+        if (queued[user] || frozen[user]) continue;
+        queued[user] = true;
+        next.push_back(user);
+      }
+    }
+    if (levels == maxDepth) {
+      if (start != -1) depthLimitProbability = 1.0 - finished[start];
+      for (int i = 0; i < count; i++) {
+        if (!unsettled[i] || frozen[i]) continue;
+        frozen[i] = true;
+        finished[i] = termination[i];
+      }
+    }
+    active.clear();
+    for (size_t n = 0; n < next.size(); n++) {
+      queued[next[n]] = false;
+      if (!frozen[next[n]]) active.push_back(next[n]);
+    }
+  }
+  if (levels < maxDepth && start != -1) depthLimitProbability = 1.0 - finished[start];
+  for (size_t a = 0; a < active.size(); a++) unsettled[active[a]] = true;
+
+  for (int i = 0; i < count; i++) {
+    if (unsettled[i] || finished[i] == 0) continue;
+    // E[depth | finite] is the sum over d >= 0 of (q - P(depth <= d)) / q
+    double q = finished[i];
+    reports[i].expectedDepth = (updated[i] * q - sumFinished[i]) / q;
+  }
+  return max(0.0, min(1.0, depthLimitProbability)); // rounding error
+}
+
+/**
+ * Returns the number of the specified nonterminal, handing out
+ * the next available number if it's never been seen before.
+ */
+
+static int intern(string_view name, unordered_map<string_view, int>& indices, vector<string_view>& names)
+{
+  unordered_map<string_view, int>::iterator found = indices.find(name);
+  if (found != indices.end()) return found->second;
+  int index = names.size();
+  names.push_back(name);
+  indices[name] = index;
+  return index;
+}
+
+GrammarAnalysis::GrammarAnalysis(const map<string_view, Definition>& grammar, string_view start,
+                                 int maxDepth, bool withDepths) :
+  startIndex(-1), maxDepth(maxDepth), depthLimitProbability(1.0)
+{
+  // the defined nonterminals are numbered in name order, since that's the
+  // order the grammar comes in, and the undefined ones are numbered as
+  // they're found and then sorted into place among them
+  unordered_map<string_view, int> indices;
+  vector<string_view> names;
+  indices.reserve(2 * grammar.size());
+  map<string_view, Definition>::const_iterator def;
+  for (def = grammar.begin(); def != grammar.end(); ++def) intern(def->first, indices, names);
+  int definedCount = names.size();
+  vector<vector<rule> > rules(definedCount);
+  int index = 0;
+  for (def = grammar.begin(); def != grammar.end(); ++def, ++index) {
+    double totalWeight = 0;
+    for (Definition::const_iterator prod = def->second.begin(); prod != def->second.end(); ++prod)
+      totalWeight += prod->getWeight();
+    for (Definition::const_iterator prod = def->second.begin(); prod != def->second.end(); ++prod) {
+      rule production = { totalWeight > 0 ? prod->getWeight() / totalWeight : 1.0 / def->second.getProductionCount(),
+                          0.0, 0.0, vector<int>() };
+      for (Production::const_iterator curr = prod->begin(); curr != prod->end(); ++curr) {
+        if (Grammar::isNonterminalText(*curr)) {
+          production.children.push_back(intern(*curr, indices, names));
+        } else {
+          production.tokens += 1;
+          production.bytes += curr->size() + 1;
+        }
+      }
+      rules[index].push_back(production);
+    }
+  }
+
+  int count = names.size();
+  vector<int> order(count);
+  for (int i = 0; i < count; i++) order[i] = i;
+  rules.resize(count);
+  if (count > definedCount) {
+    vector<int> renumbered(count);
+    sort(order.begin() + definedCount, order.end(), [&names](int one, int two) { return names[one] < names[two]; });
+    inplace_merge(order.begin(), order.begin() + definedCount, order.end(),
+                  [&names](int one, int two) { return names[one] < names[two]; });
+    vector<vector<rule> > sorted(count);
+    vector<string_view> sortedNames(count);
+    for (int i = 0; i < count; i++) {
+      renumbered[order[i]] = i;
+      sortedNames[i] = names[order[i]];
+      sorted[i].swap(rules[order[i]]);
+    }
+    for (int i = 0; i < count; i++)
+      for (size_t r = 0; r < sorted[i].size(); r++)
+        for (size_t c = 0; c < sorted[i][r].children.size(); c++)
+          sorted[i][r].children[c] = renumbered[sorted[i][r].children[c]];
+    rules.swap(sorted);
+    names.swap(sortedNames);
+  }
+  for (int i = 0; i < count; i++) {
+    nonterminalReport report = { names[i], order[i] < definedCount, false, false, 0.0, 0.0, 0.0, 0.0 };
+    reports.push_back(report);
+  }
+  if (indices.count(start) > 0) startIndex = lower_bound(names.begin(), names.end(), start) - names.begin();
+
+  // reachability: depth-first search from the start symbol
+  if (startIndex != -1) {
+    vector<int> pending(1, startIndex);
+    reports[startIndex].reachable = true;
+    while (!pending.empty()) {
+      int curr = pending.back();
+      pending.pop_back();
+      for (size_t r = 0; r < rules[curr].size(); r++) {
+        for (size_t c = 0; c < rules[curr][r].children.size(); c++) {
+          int child = rules[curr][r].children[c];
+          if (reports[child].reachable) continue;
+          reports[child].reachable = true;
+          pending.push_back(child);
+        }
+      }
+    }
+  }
+
+  // termination: a nonterminal can terminate once every child of one of its
+  // rules can, so each rule counts its children not yet known to terminate,
+  // and each nonterminal found to terminate is taken off its users' counts.
+  vector<vector<int> > unresolved(count);
+  vector<vector<pair<int, int> > > uses(count);   // every (nonterminal, rule) a child appears in
+  vector<int> pending;
+  for (int i = 0; i < count; i++) {
+    for (size_t r = 0; r < rules[i].size(); r++) {
+      unresolved[i].push_back(rules[i][r].children.size());
+      for (size_t c = 0; c < rules[i][r].children.size(); c++)
+        uses[rules[i][r].children[c]].push_back(make_pair(i, r));
+      if (rules[i][r].children.empty() && !reports[i].canTerminate) {
+        reports[i].canTerminate = true;
+        pending.push_back(i);
+      }
+    }
+  }
+  while (!pending.empty()) {
+    int curr = pending.back();
+    pending.pop_back();
+    for (size_t u = 0; u < uses[curr].size(); u++) {
+      int user = uses[curr][u].first;
+      if (--unresolved[user][uses[curr][u].second] > 0 || reports[user].canTerminate) continue;
+      reports[user].canTerminate = true;
+      pending.push_back(user);
+    }
+  }
+
+  // the graph the probabilities flow through: only rules that can be chosen count
+  vector<vector<int> > successors(count), predecessors(count);
+  for (int i = 0; i < count; i++) {
+    for (size_t r = 0; r < rules[i].size(); r++)
+      if (rules[i][r].probability > 0)
+        successors[i].insert(successors[i].end(), rules[i][r].children.begin(), rules[i][r].children.end());
+    sort(successors[i].begin(), successors[i].end());
+    successors[i].erase(unique(successors[i].begin(), successors[i].end()), successors[i].end());
+    for (size_t s = 0; s < successors[i].size(); s++) predecessors[successors[i][s]].push_back(i);
+  }
+  vector<vector<int> > components;
+  findComponents(successors, components);
+
+  // expectations and termination probabilities, one component at a time.  A
+  // nonterminal is unsettled if its component (or one it expands into) is
+  // critical, since its expansions are then finite, but not in expectation.
+  vector<double> tokens(count), bytes(count), termination(count);
+  vector<bool> unsettled(count, false);
+  vector<int> position(count, -1);
+  for (size_t k = 0; k < components.size(); k++) {
+    const vector<int>& members = components[k];
+    for (size_t m = 0; m < members.size(); m++) position[members[m]] = m;
+    bool cyclic = members.size() > 1 ||
+      binary_search(successors[members[0]].begin(), successors[members[0]].end(), members[0]);
+    growthRate growth = cyclic ? classifyGrowth(rules, members, position) : kSubcritical;
+    solveExpectations(rules, &rule::tokens, members, position, cyclic, growth, tokens);
+    solveExpectations(rules, &rule::bytes, members, position, cyclic, growth, bytes);
+    bool settled = solveTermination(rules, members, position, cyclic, growth, termination);
+    for (size_t m = 0; m < members.size() && settled; m++)
+      for (size_t s = 0; s < successors[members[m]].size() && settled; s++)
+        settled = !unsettled[successors[members[m]][s]];
+    for (size_t m = 0; m < members.size(); m++) {
+      unsettled[members[m]] = !settled;
+      position[members[m]] = -1;
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    nonterminalReport& report = reports[i];
+    report.terminationProbability = report.canTerminate ? min(1.0, termination[i]) : 0.0;
+    report.expectedTokens = tokens[i];
+    report.expectedBytes = bytes[i];
+    report.expectedDepth = kInfinity;
+    if (!report.defined) undefined.push_back(report.name);
+    else if (!report.reachable) unreachable.push_back(report.name);
+    if (report.defined && !report.canTerminate) nonterminating.push_back(report.name);
+  }
+  if (withDepths)
+    depthLimitProbability = measureDepths(rules, predecessors, termination, unsettled, startIndex, maxDepth, reports);
+}
+
+const GrammarAnalysis::nonterminalReport *GrammarAnalysis::getStartReport() const
+{
+  if (startIndex == -1) return NULL;
+  return &reports[startIndex];
+}
+
+bool GrammarAnalysis::isUsable() const
+{
+  const nonterminalReport *start = getStartReport();
+  if (start == NULL || !start->defined || !start->canTerminate) return false;
+  for (size_t i = 0; i < reports.size(); i++)
+    if (reports[i].reachable && !reports[i].defined) return false;
+  return true;
+}
+
+/**
+ * Prints the specified list of names on one line,
+ * or "(none)" if there aren't any.
+ */
+
+static void printNames(ostream& os, const string& label, const vector<string_view>& names)
+{
+  os << label << ":";
+  if (names.empty()) os << " (none)";
+  for (size_t i = 0; i < names.size(); i++) os << " " << names[i];
+  os << endl;
+}
+
+void GrammarAnalysis::printErrors(ostream& os) const
+{
+  const nonterminalReport *start = getStartReport();
+  if (start == NULL || !start->defined) {
+    os << "The grammar doesn't define a start nonterminal." << endl;
+    return;
+  }
+
+  for (size_t i = 0; i < reports.size(); i++)
+    if (reports[i].reachable && !reports[i].defined)
+      os << reports[i].name << " is used but never defined." << endl;
+  if (!start->canTerminate)
+    os << start->name << " can never finish expanding, so no sentence can be generated." << endl;
+}
+
+/**
+ * Method: printReport
+ * -------------------
+ * Lists the problems first, and then one line of
+ * statistics per nonterminal.
+ */
+
+void GrammarAnalysis::printReport(ostream& os) const
+{
+  printNames(os, "Undefined nonterminals", undefined);
+  printNames(os, "Unreachable nonterminals", unreachable);
+  printNames(os, "Nonterminals that can never terminate", nonterminating);
+  os << endl;
+
+  size_t width = 12;
+  for (size_t i = 0; i < reports.size(); i++) width = max(width, reports[i].name.size() + 2);
+  os << left << setw(width) << "nonterminal" << right << setw(12) << "P(finite)" << setw(14) << "E[tokens]"
+     << setw(14) << "E[bytes]" << setw(12) << "E[depth]" << endl;
+  for (size_t i = 0; i < reports.size(); i++) {
+    const nonterminalReport& report = reports[i];
+    os << left << setw(width) << string(report.name) << right << fixed << setprecision(6)
+       << setw(12) << report.terminationProbability << setprecision(2)
+       << setw(14) << report.expectedTokens << setw(14) << report.expectedBytes
+       << setw(12) << report.expectedDepth;
+    if (!report.defined) os << "  (undefined)";
+    else if (!report.reachable) os << "  (unreachable)";
+    os << endl;
+  }
+
+  os << endl << "Probability of exceeding the depth limit of " << maxDepth << ": "
+     << scientific << setprecision(3) << depthLimitProbability << endl;
+  os << defaultfloat;
+  if (isUsable()) return;
+  os << endl;
+  printErrors(os);
+}
@@ -0,0 +1,134 @@
+/**
+ * File: analysis.h
+ * ----------------
+ * Defines the GrammarAnalysis class, which statically examines
+ * a loaded grammar before anything is generated from it.  It finds
+ * nonterminals that are used but never defined, nonterminals that
+ * can't be reached from the start symbol, and nonterminals that
+ * can never finish expanding, and it computes how long and how deep
+ * the expansion of each nonterminal is expected to be, given the
+ * probabilities with which productions are chosen.
+ */
+
+#ifndef __analysis__
+#define __analysis__
+
+#include <iostream>
+#include <map>
+#include <string_view>
+#include <vector>
+#include "definition.h"
+using namespace std;
+
+class GrammarAnalysis {
+
+ public:
+
+  /**
+   * Struct: nonterminalReport
+   * -------------------------
+   * Everything the analysis learned about one nonterminal.  An
+   * expectation that doesn't exist (because it diverges, or because
+   * the analysis gave up on it) is reported as infinity.
+   */
+
+  struct nonterminalReport {
+    string_view name;
+    bool defined;
+    bool reachable;                  // from the start symbol
+    bool canTerminate;               // some finite derivation exists
+    double terminationProbability;   // that a random expansion is finite
+    double expectedTokens;           // terminals in a random expansion
+    double expectedBytes;            // bytes in a random expansion, separators included
+    double expectedDepth;            // nested expansions, given that it terminates
+  };
+
+  /**
+   * Constructor: GrammarAnalysis
+   * ----------------------------
+   * Analyzes the specified grammar.  Apart from the depth statistics,
+   * the running time is linear in the size of the grammar, plus the
+   * time it takes to iterate within each of its cycles (which is
+   * bounded).  The depth statistics are followed one level at a time,
+   * for as many levels as the deepest nonterminals take to settle,
+   * so they're only computed if they're asked for.
+   *
+   * @param grammar the grammar as read in from the text file.
+   * @param start the nonterminal generation begins from.
+   * @param maxDepth the depth limit the generator will be run with,
+   *                 so the chance of hitting it can be estimated.
+   * @param withDepths true if the expected depths and the chance of
+   *                   hitting the depth limit are wanted; if not, they're
+   *                   reported as infinity and 1.
+   */
+
+  GrammarAnalysis(const map<string_view, Definition>& grammar, string_view start, int maxDepth,
+                  bool withDepths = true);
+
+  /**
+   * Methods: getUndefined, getUnreachable, getNonterminating
+   * --------------------------------------------------------
+   * Return the names of the nonterminals with each problem.
+   */
+
+  const vector<string_view>& getUndefined() const { return undefined; }
+  const vector<string_view>& getUnreachable() const { return unreachable; }
+  const vector<string_view>& getNonterminating() const { return nonterminating; }
+
+  /**
+   * Method: getReports
+   * ------------------
+   * Returns one report per nonterminal (defined or not), in name order.
+   */
+
+  const vector<nonterminalReport>& getReports() const { return reports; }
+
+  /**
+   * Method: getStartReport
+   * ----------------------
+   * Returns the report for the start symbol, or NULL if
+   * the start symbol doesn't appear in the grammar at all.
+   */
+
+  const nonterminalReport *getStartReport() const;
+
+  /**
+   * Method: getDepthLimitProbability
+   * --------------------------------
+   * Returns the probability that expanding the start symbol
+   * either never terminates or exceeds the depth limit.
+   */
+
+  double getDepthLimitProbability() const { return depthLimitProbability; }
+
+  /**
+   * Predicate Method: isUsable
+   * --------------------------
+   * Returns false if generation from the start symbol is certain to
+   * fail: the start symbol is undefined, a reachable nonterminal is
+   * undefined, or the start symbol can't terminate at all.  Grammars
+   * that merely might fail (say, because they have infinite expected
+   * length) are considered usable.
+   */
+
+  bool isUsable() const;
+
+  /**
+   * Method: printErrors, printReport
+   * --------------------------------
+   * printErrors explains why the grammar isn't usable (and prints
+   * nothing if it is); printReport prints everything.
+   */
+
+  void printErrors(ostream& os) const;
+  void printReport(ostream& os) const;
+
+ private:
+  int startIndex;
+  int maxDepth;
+  double depthLimitProbability;
+  vector<nonterminalReport> reports;
+  vector<string_view> undefined, unreachable, nonterminating;
+};
+
+#endif // ! __analysis__
@@ -0,0 +1,39 @@
+/**
+ * File: arena.cc
+ * --------------
+ * Provides the implementation of the Arena class.
+ */
+
+#include <algorithm>
+#include <stdlib.h>
+#include "arena.h"
+
+const size_t Arena::kMinimumBlockSize;
+
+Arena::~Arena()
+{
+  for (size_t i = 0; i < blocks.size(); i++)
+    free(blocks[i]);
+}
+
+/**
+ * Method: allocateSlow
+ * --------------------
+ * Starts a new block when the current one can't satisfy a request.
+ * The first block honors the size hint, and each one after that is
+ * at least double the size of the one before, so a bad hint costs
+ * only a logarithmic number of blocks.  Whatever is left at the end
+ * of the old block is abandoned.
+ */
+
+void *Arena::allocateSlow(size_t bytes, size_t alignment)
+{
+  size_t size = max(kMinimumBlockSize, blocks.empty() ? sizeHint : 2 * (size_t) (limit - blocks.back()));
+  size = max(size, bytes + alignment);
+  char *block = (char *) malloc(size);
+  if (block == NULL) throw bad_alloc();
+  blocks.push_back(block);
+  next = block;
+  limit = block + size;
+  return allocate(bytes, alignment);
+}
@@ -0,0 +1,106 @@
+/**
+ * File: arena.h
+ * -------------
+ * Defines the Arena class, a bump allocator for objects that all
+ * live exactly as long as one another.  Memory is carved out of a few
+ * large blocks by advancing a pointer, nothing is freed individually,
+ * and the whole arena is released at once when it's destroyed.
+ * Objects placed in an Arena must not need their destructors run.
+ */
+
+#ifndef __arena__
+#define __arena__
+
+#include <new>
+#include <stddef.h>
+#include <vector>
+using namespace std;
+
+class Arena {
+
+ public:
+
+  /**
+   * The smallest block the Arena ever allocates.
+   */
+
+  static const size_t kMinimumBlockSize = 64 << 10;
+
+  /**
+   * Constructor: Arena
+   * ------------------
+   * Constructs an empty arena.  Nothing is allocated until the
+   * first request arrives, and then the first block is made large
+   * enough for sizeHint bytes, so a client that knows roughly how
+   * much it needs gets all of its objects in a single block.
+   */
+
+  Arena(size_t sizeHint = 0) : next(NULL), limit(NULL), sizeHint(sizeHint) {}
+
+  /**
+   * Destructor: ~Arena
+   * ------------------
+   * Releases every block, and with them everything
+   * ever allocated from the arena.
+   */
+
+  ~Arena();
+
+  /**
+   * Method: allocate
+   * ----------------
+   * Returns uninitialized memory for the specified number of bytes,
+   * aligned as specified (which must be a power of two).
+   */
+
+  void *allocate(size_t bytes, size_t alignment = alignof(max_align_t));
+
+  /**
+   * Method: copy
+   * ------------
+   * Copies count trivially copyable objects into the
+   * arena, contiguously, and returns the address of the first.
+   */
+
+  template <typename T>
+  T *copy(const T *objects, size_t count);
+
+  /**
+   * Method: getBlockCount
+   * ---------------------
+   * Returns the number of blocks allocated so far.
+   */
+
+  size_t getBlockCount() const { return blocks.size(); }
+
+ private:
+  char *next;
+  char *limit;
+  size_t sizeHint;
+  vector<char *> blocks;
+
+  void *allocateSlow(size_t bytes, size_t alignment);
+
+  // marked as private so two Arenas can't release
+  // the same blocks (do NOT implement these).
+  Arena(const Arena& original);
+  Arena& operator=(const Arena& rhs);
+};
+
+inline void *Arena::allocate(size_t bytes, size_t alignment)
+{
+  char *aligned = (char *) (((size_t) next + alignment - 1) & ~(alignment - 1));
+  if (next == NULL || bytes > (size_t) (limit - aligned)) return allocateSlow(bytes, alignment);
+  next = aligned + bytes;
+  return aligned;
+}
+
+template <typename T>
+T *Arena::copy(const T *objects, size_t count)
+{
+  T *copied = (T *) allocate(count * sizeof(T), alignof(T));
+  for (size_t i = 0; i < count; i++) new (copied + i) T(objects[i]);
+  return copied;
+}
+
+#endif // ! __arena__
@@ -0,0 +1,51 @@
+/**
+ * File: batch.cc
+ * --------------
+ * Provides the implementation of generateBatch.
+ */
+
+#include <algorithm>
+#include "batch.h"
+#include "random.h"
+
+bool generateBatch(SentenceGenerator& generator, const vector<batchJob>& jobs,
+                   OutputBuffer& out, vector<sentenceSpan> *sentences, string& errorMessage)
+{
+  const Grammar& grammar = generator.getGrammar();
+  size_t outStart = out.size();
+  size_t sentencesStart = sentences != NULL ? sentences->size() : 0;
+  if (sentences != NULL) {
+    long total = 0;
+    for (size_t j = 0; j < jobs.size(); j++) total += max(jobs[j].count, 0L);
+    sentences->reserve(sentencesStart + total);
+  }
+
+  for (size_t j = 0; j < jobs.size(); j++) {
+    const batchJob& job = jobs[j];
+    int start = grammar.lookup(job.start);
+    if (start == -1 || !grammar.isNonterminal(start) || grammar.getProductionCount(start) == 0) {
+      errorMessage = "The grammar doesn't define " + string(job.start) + ".";
+      out.rewind(outStart);
+      if (sentences != NULL) sentences->resize(sentencesStart);
+      return false;
+    }
+
+    RandomGenerator random(job.seed);
+    for (long i = 0; i < job.count; i++) {
+      size_t offset = out.size();
+      if (!generator.generate(start, random, out)) {
+        errorMessage = generator.getErrorMessage();
+        out.rewind(outStart);
+        if (sentences != NULL) sentences->resize(sentencesStart);
+        return false;
+      }
+      if (sentences != NULL) {
+        sentenceSpan span = { offset, out.size() - offset };
+        sentences->push_back(span);
+      }
+      out.put('\n');
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,78 @@
+/**
+ * File: batch.h
+ * -------------
+ * Defines the interface for generating several batches of sentences,
+ * each from its own start symbol and seed, in a single call.  Every
+ * sentence lands in one contiguous block of memory, and is handed back
+ * as a span of that block, so a caller that wants thousands of short
+ * sentences isn't handed thousands of separately allocated strings.
+ */
+
+#ifndef __batch__
+#define __batch__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+#include "generator.h"
+#include "output.h"
+using namespace std;
+
+/**
+ * Struct: batchJob
+ * ----------------
+ * Asks for count sentences expanding the named nonterminal, using
+ * a RandomGenerator seeded with seed.  The same job always produces
+ * the same sentences from the same grammar.
+ */
+
+struct batchJob {
+  string_view start;
+  long count;
+  uint64_t seed;
+};
+
+/**
+ * Struct: sentenceSpan
+ * --------------------
+ * Locates one sentence within the output block, as an offset
+ * from the start of OutputBuffer::data() and a length, which
+ * doesn't include the '\n' that follows every sentence.
+ */
+
+struct sentenceSpan {
+  size_t offset;
+  size_t length;
+
+  string_view in(const OutputBuffer& out) const { return string_view(out.data() + offset, length); }
+};
+
+/**
+ * Function: generateBatch
+ * -----------------------
+ * Runs every job in order, appending each sentence (followed by '\n')
+ * to out and its span to sentences, so the sentences of job j follow
+ * those of job j - 1.  The caller's SentenceGenerator serves every job,
+ * so a caller that keeps its generator between calls only grows the
+ * expansion stack once, and each start symbol is looked up once per
+ * job rather than once per sentence.
+ *
+ * @param generator the generator, over the grammar to generate from.
+ * @param jobs the batches to generate.
+ * @param out a buffer that grows in memory (see OutputBuffer()), which
+ *            may already hold data; spans are relative to out.data(),
+ *            so they remain valid if out has to grow.
+ * @param sentences the spans are appended here, unless it's NULL
+ *                  (for callers that only want the text).
+ * @param errorMessage updated with a description of the problem
+ *                     if a job fails.
+ * @return true if every job succeeded, and false if a start symbol
+ *         isn't defined or a sentence couldn't be generated, in which
+ *         case out and sentences are left exactly as they were.
+ */
+
+bool generateBatch(SentenceGenerator& generator, const vector<batchJob>& jobs,
+                   OutputBuffer& out, vector<sentenceSpan> *sentences, string& errorMessage);
+
+#endif // ! __batch__
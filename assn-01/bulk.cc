@@ -0,0 +1,391 @@
+/**
+ * File: bulk.cc
+ * -------------
+ * Provides the implementation of generateBulk.  The threads claim
+ * blocks of consecutive sentences from a shared counter, so a thread
+ * that finishes early just claims more, and the only points of
+ * contention are the counter and the hand-off of each finished block
+ * to the shared OutputBuffer, which happens in order of block number.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string.h>
+#include "bulk.h"
+#include "fingerprints.h"
+#include "generator.h"
+#include "output.h"
+#include "random.h"
+
+/**
+ * Blocks are sized to fill about this many bytes, if the
+ * expected length of a sentence is known.
+ */
+
+static const size_t kChunkSize = 1 << 20;
+
+/**
+ * The number of sentences in a block when the expected length of a
+ * sentence isn't known, and the bounds on it when it is.
+ */
+
+static const long kDefaultBlockSentences = 1024;
+static const long kMinBlockSentences = 16;
+static const long kMaxBlockSentences = 1 << 16;
+
+/**
+ * A thread's buffer is sized up front so that a chunk can overshoot
+ * kChunkSize by a few expected sentences without reallocating, but
+ * a wildly large hint doesn't get to reserve more than this.
+ */
+
+static const size_t kMaxReserve = 64 << 20;
+
+/**
+ * When generating distinct sentences, the run gives up once this
+ * many sentences in a row, or kStallFactor times the number of
+ * distinct ones written so far if that's more, turn up nothing new.
+ */
+
+static const long kMinStallSentences = 1 << 16;
+static const long kStallFactor = 16;
+
+/**
+ * A sentence that can't be generated (because it hits the depth
+ * limit, say) is tried again, carrying on along its own random
+ * stream, up to this many times in all before it's left out.
+ */
+
+static const int kMaxAttempts = 64;
+
+/**
+ * Struct: bulkState
+ * -----------------
+ * Everything the worker threads share.  The mutex guards the
+ * shared output (which drains into the file descriptor), the
+ * counts of what's been written, and the error message.  Once a
+ * block fails, no later block is written, but every earlier one
+ * still is, so the run stops at the same place however many
+ * threads there are.  Sentences left out are tallied as their
+ * blocks are written, so the tally doesn't depend on the threads
+ * either.
+ */
+
+struct bulkState {
+  bulkState(int fd, long blockSentences) :
+    output(fd, kChunkSize), blockSentences(blockSentences), nextBlock(0), writtenBlocks(0),
+    distinctWritten(0), sinceDistinct(0), skipped(0), failedBlock(LONG_MAX), finished(false) {}
+  OutputBuffer output;
+  long blockSentences;
+  atomic<long> nextBlock;       // the next block to be claimed
+  long writtenBlocks;
+  unique_ptr<FingerprintTable> seen; // NULL unless only distinct sentences are wanted
+  long distinctWritten;
+  long sinceDistinct;           // sentences since the last distinct one, in order
+  long skipped;                 // sentences left out of the blocks written so far
+  string skipMessage;           // why the first of them was left out
+  mutex lock;
+  condition_variable written;   // notified whenever a block is written, or the run ends
+  atomic<long> failedBlock;      // the earliest block to fail, or LONG_MAX; only lowered under the lock
+  atomic<bool> finished;        // enough distinct sentences have been written
+  string errorMessage;
+};
+
+/**
+ * Records that the specified block failed, unless an earlier one already
+ * has, and wakes the threads waiting for their turn to write, since
+ * those holding later blocks can give up.  Threads holding earlier
+ * blocks carry on, and should one of them fail, its failure is the
+ * one reported.  The lock must already be held.
+ */
+
+static void recordFailure(bulkState& state, long block, const string& message)
+{
+  if (block >= state.failedBlock) return;
+  state.errorMessage = message;
+  state.failedBlock = block;
+  state.written.notify_all();
+}
+
+/**
+ * Adds the specified number of sentences to the tally of those left
+ * out, remembering the message if they're the first.  The lock must
+ * already be held.
+ */
+
+static void recordSkipped(bulkState& state, long skipped, const string& message)
+{
+  if (skipped == 0) return;
+  if (state.skipped == 0) state.skipMessage = message;
+  state.skipped += skipped;
+}
+
+/**
+ * Waits until every block before the specified one has been written,
+ * then hands the thread's entire buffer (which holds that block) to
+ * the shared output, and empties the buffer (without releasing its
+ * memory) so it can be reused.  A block of at least kChunkSize bytes
+ * goes straight to write(2) without being copied again.  skipped is the
+ * number of the block's sentences that were left out, and skipMessage
+ * says why the first of them was.  Returns false if an earlier block
+ * failed, or the write did.
+ */
+
+static bool writeBlock(bulkState& state, long block, OutputBuffer& buffer, long skipped, const string& skipMessage)
+{
+  unique_lock<mutex> guard(state.lock);
+  state.written.wait(guard, [&state, block] { return state.writtenBlocks == block || block > state.failedBlock; });
+  if (block > state.failedBlock) return false;
+  state.output.append(buffer.data(), buffer.size());
+  recordSkipped(state, skipped, skipMessage);
+  state.writtenBlocks++;
+  state.written.notify_all();
+  buffer.clear();
+  if (state.output.good()) return true;
+  recordFailure(state, block, string("Failed to write sentences: ") + strerror(state.output.getErrorNumber()));
+  return false;
+}
+
+/**
+ * Like writeBlock, but only writes the sentences that are the first of
+ * their kind, stopping once options.count of those have been written.
+ * By the time a block's turn comes, every earlier sentence is in the
+ * table, so the table knows whether any of them was the same.  ends
+ * records where each sentence in the buffer ends (just past its '\n'),
+ * and a sentence that was left out ends where it began.
+ */
+
+static bool writeDistinct(bulkState& state, long block, OutputBuffer& buffer, vector<uint64_t>& fingerprints,
+                          vector<size_t>& ends, const string& skipMessage, const bulkOptions& options)
+{
+  unique_lock<mutex> guard(state.lock);
+  state.written.wait(guard, [&state, block] {
+    return state.writtenBlocks == block || block > state.failedBlock || state.finished;
+  });
+  if (block > state.failedBlock || state.finished) return false;
+
+  long first = block * state.blockSentences;
+  size_t begin = 0;
+  for (size_t j = 0; j < ends.size(); begin = ends[j++]) {
+    if (ends[j] == begin) {
+      recordSkipped(state, 1, skipMessage);
+    } else if (state.seen->getFirstIndex(fingerprints[j]) == (uint64_t) (first + j)) {
+      state.output.append(buffer.data() + begin, ends[j] - begin);
+      state.sinceDistinct = 0;
+      if (++state.distinctWritten < options.count) continue;
+      state.finished = true;
+      break;
+    }
+    if (++state.sinceDistinct >= max(kMinStallSentences, kStallFactor * state.distinctWritten)) {
+      recordFailure(state, block, "Only " + to_string(state.distinctWritten) + " distinct sentences turned up, and none " +
+                    "in the last " + to_string(state.sinceDistinct) + ", so the grammar appears to have fewer than " +
+                    to_string(options.count) + ".");
+      return false;
+    }
+  }
+
+  state.writtenBlocks++;
+  state.written.notify_all();
+  buffer.clear();
+  fingerprints.clear();
+  ends.clear();
+  if (state.output.good()) return !state.finished;
+  recordFailure(state, block, string("Failed to write sentences: ") + strerror(state.output.getErrorNumber()));
+  return false;
+}
+
+/**
+ * Lets generateSentences drive either kind of generator.
+ */
+
+static bool generateSentence(SentenceGenerator& generator, int start, RandomGenerator& random, OutputBuffer& out)
+{
+  return generator.generate(start, random, out);
+}
+
+static bool generateSentence(UniformGenerator& generator, int, RandomGenerator& random, OutputBuffer& out)
+{
+  return generator.generate(random, out);
+}
+
+/**
+ * Claims blocks until there are none left, generating each into a
+ * private buffer with the specified generator, and reseeding the
+ * RandomGenerator for every sentence from the sentence's own index.
+ * A sentence that fails is retried from where its stream left off,
+ * so the retries are as reproducible as the first try, and one that
+ * fails every time is left out of its block.  When only distinct
+ * sentences are wanted, there's no last block; every sentence is
+ * entered in the table as soon as it's generated, and the blocks
+ * keep coming until enough distinct ones are written.
+ */
+
+template <typename Generator>
+static void generateSentences(Generator& generator, int start, const bulkOptions& options, bulkState& state)
+{
+  OutputBuffer buffer;
+  double overshoot = max(kChunkSize / 4.0, 4 * options.sentenceBytesHint);
+  buffer.reserve(min(kChunkSize + (size_t) overshoot, kMaxReserve));
+
+  vector<uint64_t> fingerprints;
+  vector<size_t> ends;
+  long skipped = 0;
+  string skipMessage;
+  RandomGenerator random(options.seed);
+  while (!state.finished.load(memory_order_relaxed)) {
+    long block = state.nextBlock++;
+    long first = block * state.blockSentences;
+    if (block > state.failedBlock.load(memory_order_relaxed)) return;
+    if (!options.distinct && first >= options.count) return;
+    long last = options.distinct ? first + state.blockSentences : min(options.count, first + state.blockSentences);
+    for (long i = first; i < last; i++) {
+      random.setSeed(options.seed, options.offset + i);
+      bool generated = false;
+      for (int attempt = 0; attempt < kMaxAttempts && !generated; attempt++)
+        generated = generateSentence(generator, start, random, buffer);
+      if (!generated) {
+        if (skipped++ == 0) skipMessage = "Sentence " + to_string(options.offset + i) + ": " + generator.getErrorMessage();
+        if (options.distinct) {
+          fingerprints.push_back(0);
+          ends.push_back(buffer.size());
+        }
+        continue;
+      }
+      if (options.distinct) {
+        size_t begin = ends.empty() ? 0 : ends.back();
+        fingerprints.push_back(FingerprintTable::getFingerprint(string_view(buffer.data() + begin, buffer.size() - begin)));
+        state.seen->insert(fingerprints.back(), i);
+      }
+      buffer.put('\n');
+      if (options.distinct) ends.push_back(buffer.size());
+    }
+    if (options.distinct ? !writeDistinct(state, block, buffer, fingerprints, ends, skipMessage, options) :
+        !writeBlock(state, block, buffer, skipped, skipMessage)) return;
+    skipped = 0;
+  }
+}
+
+/**
+ * Thread routine which generates blocks of sentences with
+ * a private generator, random stream and buffer.
+ */
+
+static void generateShare(const Grammar& grammar, int start, const bulkOptions& options, bulkState& state)
+{
+  if (options.uniform != NULL) {
+    UniformGenerator generator(*options.uniform);
+    generateSentences(generator, start, options, state);
+  } else {
+    SentenceGenerator generator(grammar, options.maxDepth);
+    unique_ptr<ExpansionProfile> profile;
+    if (options.profile != NULL) {
+      profile.reset(new ExpansionProfile(grammar));
+      generator.setProfile(profile.get());
+    }
+    generateSentences(generator, start, options, state);
+    if (profile != NULL) {
+      lock_guard<mutex> guard(state.lock);
+      options.profile->merge(*profile);
+    }
+  }
+}
+
+/**
+ * Returns the number of sentences in a block: enough to fill about
+ * kChunkSize bytes, if the expected length of a sentence is known.
+ */
+
+static long getBlockSentences(const bulkOptions& options)
+{
+  if (options.sentenceBytesHint <= 0) return kDefaultBlockSentences;
+  double sentences = kChunkSize / options.sentenceBytesHint;
+  return (long) max((double) kMinBlockSentences, min((double) kMaxBlockSentences, sentences));
+}
+
+/**
+ * Returns the number of derivations of the specified nonterminal,
+ * which is infinite if it can (directly or indirectly) expand itself.
+ * Every nonterminal's count is the sum over its productions of the
+ * products of their nonterminals' counts, so the counts are computed
+ * in an order where every nonterminal comes after those it expands to;
+ * the nonterminals on or above a cycle never get their turn.
+ */
+
+static double countDerivations(const Grammar& grammar, int start)
+{
+  int nonterminalCount = grammar.getNonterminalCount();
+  vector<int> pending(nonterminalCount, 0);      // references not yet counted
+  vector<vector<int> > referrers(nonterminalCount);
+  for (int nonterminal = 0; nonterminal < nonterminalCount; nonterminal++) {
+    int firstProduction = grammar.getFirstProduction(nonterminal);
+    for (int p = firstProduction; p < firstProduction + grammar.getProductionCount(nonterminal); p++) {
+      for (const int32_t *curr = grammar.productionBegin(p); curr != grammar.productionEnd(p); ++curr) {
+        if (!grammar.isNonterminal(*curr)) continue;
+        pending[nonterminal]++;
+        referrers[*curr].push_back(nonterminal);
+      }
+    }
+  }
+
+  vector<double> counts(nonterminalCount, INFINITY);
+  vector<int> ready;
+  for (int nonterminal = 0; nonterminal < nonterminalCount; nonterminal++)
+    if (pending[nonterminal] == 0) ready.push_back(nonterminal);
+  while (!ready.empty()) {
+    int nonterminal = ready.back();
+    ready.pop_back();
+    double total = 0;
+    int firstProduction = grammar.getFirstProduction(nonterminal);
+    for (int p = firstProduction; p < firstProduction + grammar.getProductionCount(nonterminal); p++) {
+      double product = 1;
+      for (const int32_t *curr = grammar.productionBegin(p); curr != grammar.productionEnd(p); ++curr)
+        if (grammar.isNonterminal(*curr)) product *= counts[*curr];
+      total += product;
+    }
+    counts[nonterminal] = total;
+    for (size_t i = 0; i < referrers[nonterminal].size(); i++)
+      if (--pending[referrers[nonterminal][i]] == 0) ready.push_back(referrers[nonterminal][i]);
+  }
+
+  return counts[start];
+}
+
+bool generateBulk(const Grammar& grammar, int start, const bulkOptions& options,
+                  int fd, long& skipped, string& errorMessage)
+{
+  skipped = 0;
+  bulkState state(fd, getBlockSentences(options));
+  if (options.distinct) {
+    double derivations = options.uniform != NULL ? (double) options.uniform->getDerivationCount() :
+      countDerivations(grammar, start);
+    if (derivations < options.count) {
+      errorMessage = "The start symbol has only " + to_string((long) derivations) + " derivations, so the grammar " +
+        "can't produce " + to_string(options.count) + " distinct sentences.";
+      return false;
+    }
+    state.seen.reset(new FingerprintTable(options.count + (size_t) options.threads * state.blockSentences));
+  }
+
+  vector<thread> workers;
+  for (int i = 0; i < options.threads; i++)
+    workers.push_back(thread(generateShare, cref(grammar), start, cref(options), ref(state)));
+
+  for (size_t i = 0; i < workers.size(); i++)
+    workers[i].join();
+
+  if (!state.output.flush() && state.failedBlock == LONG_MAX)
+    recordFailure(state, state.writtenBlocks, string("Failed to write sentences: ") +
+                  strerror(state.output.getErrorNumber()));
+
+  skipped = state.skipped;
+  if (state.failedBlock != LONG_MAX) errorMessage = state.errorMessage;
+  else if (skipped > 0) errorMessage = state.skipMessage;
+  return state.failedBlock == LONG_MAX;
+}
@@ -0,0 +1,94 @@
+/**
+ * File: bulk.h
+ * ------------
+ * Defines the interface for generating a large number of
+ * sentences from one compiled Grammar using several threads
+ * at once.  The grammar is shared read-only; each thread owns
+ * its own SentenceGenerator, RandomGenerator and output buffer.
+ * Every sentence is generated from a random stream of its own, so
+ * the output never depends on how many threads share the work.
+ */
+
+#ifndef __bulk__
+#define __bulk__
+
+#include <string>
+#include <stdint.h>
+#include "grammar.h"
+#include "profiler.h"
+#include "uniform.h"
+using namespace std;
+
+/**
+ * Struct: bulkOptions
+ * -------------------
+ * Bundles the parameters of a bulk generation run.
+ */
+
+struct bulkOptions {
+  long count;          // total number of sentences to generate
+  bool distinct;       // if so, repeats aren't written, or counted
+  uint64_t offset;     // the index of the first of them
+  int threads;         // number of worker threads, at least 1
+  uint64_t seed;       // seed from which every sentence's stream is derived
+  int maxDepth;        // forwarded to each SentenceGenerator
+  double sentenceBytesHint; // expected sentence length, or 0 if unknown
+  const ExpansionCounts *uniform; // NULL unless derivations are sampled uniformly
+  ExpansionProfile *profile; // NULL unless expansions are profiled (uniform sampling isn't)
+};
+
+/**
+ * Function: generateBulk
+ * ----------------------
+ * Generates options.count sentences by expanding the specified
+ * nonterminal, and writes them to the specified file descriptor,
+ * one per line.  Sentence i (counting from options.offset) is generated
+ * from stream i of options.seed (see RandomGenerator::setSeed), and the
+ * sentences are written in order of i, so the output is the same no
+ * matter how many threads there are, and any range of sentences from
+ * a run can be regenerated on its own by starting at its offset.
+ *
+ * The sentences are dealt out to the threads in blocks.  Each thread
+ * generates a block into a private buffer and then waits (if it must)
+ * for the blocks before it to be written, so only one block per thread
+ * is ever held in memory.
+ *
+ * With options.distinct, generation continues past options.count
+ * sentences until that many distinct ones have been written; a
+ * sentence is written only if no sentence before it was the same.
+ * Sentences are remembered by fingerprint only (see fingerprints.h).
+ * The run fails up front if the start symbol has fewer derivations
+ * than that (which can only be known for a grammar without recursion,
+ * or when sampling uniformly), and fails partway through if the
+ * distinct sentences appear to have run out: if a long stretch of
+ * sentences (sixteen times as many as have been written, and at
+ * least 65536) turns up nothing new.
+ *
+ * A sentence that can't be generated (most often because it would
+ * exceed the depth limit) is tried again, carrying on along its own
+ * stream, so it comes out the same on every run.  One that fails
+ * every time is left out and counted, and doesn't stop the run; in
+ * distinct mode, it's counted toward the stretch without anything new.
+ *
+ * If a profile is requested, each
+ * thread profiles its own expansions, and the threads' profiles are
+ * merged into the requested one as they finish.
+ *
+ * @param grammar the compiled grammar, shared by all threads.
+ * @param start the id of the nonterminal each sentence expands.
+ * @param options the size and shape of the run.
+ * @param fd the open file descriptor receiving the sentences.
+ * @param skipped updated with the number of sentences left out.
+ * @param errorMessage updated with a description of the problem
+ *                     if the run fails, or else with why the first
+ *                     sentence left out (if any) couldn't be generated.
+ * @return true unless the sentences couldn't be written, or the
+ *         distinct ones ran out.  On failure, the blocks before the
+ *         one where it happened are still written, however many
+ *         threads there are.
+ */
+
+bool generateBulk(const Grammar& grammar, int start, const bulkOptions& options,
+                  int fd, long& skipped, string& errorMessage);
+
+#endif // ! __bulk__
@@ -8,32 +8,43 @@
  */ 
  
 #include "definition.h"
-#include "random.h"
+#include "alias.h"
 
 /**
  * Constructor: Definition
  * -----------------------
  * Constructs an instance of a Definition object
- * based on the content of the specified file.  Relies
+ * based on the text addressed by the specified tokenizer.  Relies
  * on the correct implementation of the Production
- * constructor which also takes an ifstream reference.
- * The strong assumption is that the file reference is
+ * constructor which also takes a GrammarTokenizer reference.
+ * The strong assumption is that the tokenizer is
  * poised to read the opening '{' as the very first character.
  */
 
-Definition::Definition(ifstream& infile)
+Definition::Definition(GrammarTokenizer& tokenizer, Arena& arena, scratchSpace& scratch) : weighted(false)
 {
-  string uselessText;
-  getline(infile, uselessText, '{');
-  infile >> nonterminal;
-  getline(infile, uselessText); // stop character defaults to '\n'
+  tokenizer.skipPast('{');
+  nonterminal = tokenizer.nextToken();
+  tokenizer.skipLine();
 
-  while (infile.peek() != '}') {
-    Production possibleExpansion(infile);
-    possibleExpansions.push_back(possibleExpansion);
+  scratch.productions.clear();
+  while (tokenizer.peek() != '}' && !tokenizer.atEnd()) {
+    scratch.productions.push_back(Production(tokenizer, arena, scratch.phrases));
   }
   
-  getline(infile, uselessText, '}');
+  tokenizer.skipPast('}');
+  productions = arena.copy(scratch.productions.data(), scratch.productions.size());
+  count = scratch.productions.size();
+
+  scratch.weights.clear();
+  for (const_iterator prod = begin(); prod != end(); ++prod) {
+    scratch.weights.push_back(prod->getWeight());
+    if (prod->getWeight() != productions[0].getWeight()) weighted = true;
+  }
+  if (!weighted) scratch.weights.assign(count, 1.0);
+  buildAliasTable(scratch.weights, scratch.thresholds, scratch.aliases);
+  thresholds = arena.copy(scratch.thresholds.data(), scratch.thresholds.size());
+  aliases = arena.copy(scratch.aliases.data(), scratch.aliases.size());
 }
 
 /**
@@ -41,13 +52,16 @@ Definition::Definition(ifstream& infile)
  * ---------------------------
  * Returns a const reference to one of the
  * embedded Productions.  Relies on the
- * correct implementation of the RandomNumberGenerator
- * class, but is otherwise a no-brainer.
+ * correct implementation of the RandomGenerator
+ * class, but is otherwise a no-brainer: choose a
+ * column of the alias table uniformly, and then
+ * flip its biased coin unless it always keeps itself.
  */
 
-const Production& Definition::getRandomProduction() const
+const Production& Definition::getRandomProduction(RandomGenerator& random) const
 {
-  static RandomGenerator random; 
-  int randomIndex = random.getRandomInteger(0, possibleExpansions.size() - 1);
-  return possibleExpansions[randomIndex];
+  int randomIndex = random.getRandomInteger(0, count - 1);
+  if (aliases[randomIndex] != randomIndex &&
+      (uint32_t) random.getRandomBits() >= thresholds[randomIndex]) randomIndex = aliases[randomIndex];
+  return productions[randomIndex];
 }
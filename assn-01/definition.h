@@ -7,15 +7,45 @@
  * Encapulates the data necessary to capture
  * the notion of a CFG Definition.  A Definition
  * is just a nonterminal paired with all of
- * it's possible expansions.
+ * it's possible expansions.  The expansions and
+ * the alias table live in an Arena, so a Definition
+ * is a small view that's cheap to copy.
  */
 
+#include "arena.h"
 #include "production.h"
+#include "random.h"
 #include <vector>
 using namespace std;  
 
 class Definition {
   
+ public:
+
+  /**
+   * Provides STL-like iterator access to the sequence of Productions
+   * making up a Definition instance.
+   */
+
+  typedef const Production *const_iterator;
+
+  /**
+   * Struct: scratchSpace
+   * --------------------
+   * The growable buffers a Definition is assembled in before it's
+   * copied into the Arena.  Reusing one scratchSpace for every
+   * Definition in a file means the buffers stop reallocating once
+   * they've grown to fit the largest Definition.
+   */
+
+  struct scratchSpace {
+    vector<string_view> phrases;
+    vector<Production> productions;
+    vector<double> weights;
+    vector<uint32_t> thresholds;
+    vector<int32_t> aliases;
+  };
+
  public:
   
   /**
@@ -29,15 +59,14 @@ class Definition {
    * requires its elements to have a default constructor.
    */
   
-  Definition() {}
+  Definition() : productions(NULL), count(0), weighted(false), thresholds(NULL), aliases(NULL) {}
   
   /**
-   * ifstream Constructor: Definition
-   * --------------------------------
+   * GrammarTokenizer Constructor: Definition
+   * ----------------------------------------
    * Constructs an instance of the Definition instance
-   * based on the contents of the specified ifstream.  The
-   * contents of the file must adhere to the following
-   * textual representation:
+   * based on the text addressed by the specified tokenizer.  The
+   * text must adhere to the following textual representation:
    * 
    *			{
    *			<non-terminal>
@@ -48,50 +77,93 @@ class Definition {
    *          	                <production-n> ;
    *			}
    *
-   * The ifstream must be poised to read the '{' as
+   * The tokenizer must be poised to read the '{' as
    * the very next character, and it consumes everything up
-   * to and including the '}' character.  The file is assumed
-   * to be properly formatted.
+   * to and including the '}' character.  The text is assumed
+   * to be properly formatted.  The nonterminal and every Production
+   * refer directly into the text, and the Productions and alias table
+   * are placed in the arena, so both must outlive the Definition.
    *
-   * @param infile a reference to the flat text grammar file being read.
-   *               We assume that the stream pointer is directly addressing
-   *               an open curly brace as the next character.  If not, then
-   *               the implementation makes no guarantees as to how the
-   *               constructor behaves.
+   * @param tokenizer a reference to the tokenizer walking the grammar text.
+   *                  We assume that it is directly addressing an open
+   *                  curly brace as the next character.  If not, then
+   *                  the implementation makes no guarantees as to how the
+   *                  constructor behaves.
+   * @param arena the arena that everything but the text is copied into.
+   * @param scratch buffers for the constructor to work in.
    */
   
-  Definition(ifstream& infile);
+  Definition(GrammarTokenizer& tokenizer, Arena& arena, scratchSpace& scratch);
 
   /**
    * Method: getNonterminal
    * ----------------------
-   * Returns a constant reference to the 
-   * embedded nonterminal.
+   * Returns a view of the embedded nonterminal.
    *
-   * @return an immutable reference to a string, which stores
-   *         the nonterminal string (with the '<' and '>' on
-   *         either side.
+   * @return a string_view addressing the nonterminal (with
+   *         the '<' and '>' on either side) in the grammar text.
    */
   
-  const string& getNonterminal() const { return nonterminal; }
+  string_view getNonterminal() const { return nonterminal; }
   
   /**
    * Method: getRandomProduction
    * ---------------------------
    * Returns an immutable reference to one and
    * exactly one of the Definition's expansions.
-   * The Production is chosen at random.
+   * The Production is chosen at random, in proportion
+   * to its weight, in constant time regardless of how
+   * many Productions there are.
    *
+   * @param random the generator that supplies the randomness.  Passing
+   *               it in (rather than sharing one hidden instance) lets
+   *               each thread draw from its own stream.
    * @return an immutable reference to a randomly selected
    *         Production held by the Definition.  It is assumed
    *         that the Definition has at least one Production.
    */
   
-  const Production& getRandomProduction() const;
+  const Production& getRandomProduction(RandomGenerator& random) const;
+
+  /**
+   * Iterators: begin, end
+   * ---------------------
+   * Provides read-only traversal of all of the Definition's
+   * Productions, in the order they appeared in the grammar file.
+   */
+
+  const_iterator begin() const { return productions; }
+  const_iterator end() const { return productions + count; }
+
+  /**
+   * Method: getProductionCount
+   * --------------------------
+   * Returns the number of Productions held by the Definition.
+   */
+
+  int getProductionCount() const { return count; }
+
+  /**
+   * Methods: isWeighted, getThreshold, getAlias
+   * -------------------------------------------
+   * Expose the alias table built when the Definition was
+   * constructed (see alias.h), so that compiled forms of the
+   * grammar can reuse it rather than rebuild it.  A Definition
+   * whose Productions all have the same weight isn't weighted,
+   * and its alias table is the identity.
+   */
+
+  bool isWeighted() const { return weighted; }
+  uint32_t getThreshold(int index) const { return thresholds[index]; }
+  int getAlias(int index) const { return aliases[index]; }
   
  private:
-  string nonterminal;
-  vector<Production> possibleExpansions;
+  string_view nonterminal;
+  const Production *productions;
+  int count;
+  bool weighted;
+  const uint32_t *thresholds;
+  const int32_t *aliases;
 };
 
 #endif // ! __definition__
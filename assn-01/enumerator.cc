@@ -0,0 +1,256 @@
+/**
+ * File: enumerator.cc
+ * -------------------
+ * Provides the implementation of the DerivationEnumerator class.
+ * The current derivation is kept only as its list of choices.  To
+ * advance, the latest choice with a viable later alternative is bumped,
+ * everything after it is dropped, and the derivation is replayed from
+ * the start, with each new choice being the first viable one.  Replaying
+ * costs no more than emitting the sentence does, and it means nothing
+ * but the choices has to be saved, or restored on backtracking.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include "enumerator.h"
+#include "grammar.h"
+
+/**
+ * Stands in for the yield of a nonterminal that can't
+ * finish expanding within the depth it's allowed.
+ */
+
+static const int kInfinite = INT_MAX;
+
+/**
+ * Adds two yields, either of which may be kInfinite.
+ */
+
+static int addTokens(int a, int b)
+{
+  return a >= kInfinite - b ? kInfinite : a + b;
+}
+
+/**
+ * Constructor: DerivationEnumerator
+ * ---------------------------------
+ * Numbers the nonterminals and resolves every symbol of every Production
+ * to its nonterminal's number up front, so that expansion never needs to
+ * look anything up by name.  minimumTokens[h][n] is the fewest terminals
+ * nonterminal n can yield in a derivation at most h levels deep; each row
+ * follows from the one before, and the rows stop changing once h is
+ * large enough, so only that many are kept.
+ */
+
+DerivationEnumerator::DerivationEnumerator(const map<string_view, Definition>& grammar, string_view start,
+                                           int maxDepth, int maxTokens) :
+  maxDepth(maxDepth), maxTokens(min(maxTokens, kInfinite - 1)), start(-1), started(false)
+{
+  map<string_view, int> ids;
+  map<string_view, Definition>::const_iterator def;
+  for (def = grammar.begin(); def != grammar.end(); ++def) {
+    int id = ids.size();
+    ids[def->first] = id;
+  }
+  if (ids.count(start) > 0) this->start = ids[start];
+
+  for (def = grammar.begin(); def != grammar.end(); ++def) {
+    firstProduction.push_back(productions.size());
+    for (Definition::const_iterator prod = def->second.begin(); prod != def->second.end(); ++prod) {
+      productions.push_back(&*prod);
+      bodyStarts.push_back(bodies.size());
+      for (Production::const_iterator curr = prod->begin(); curr != prod->end(); ++curr) {
+        map<string_view, int>::const_iterator found = ids.find(*curr);
+        if (!Grammar::isNonterminalText(*curr)) bodies.push_back(-1);
+        else bodies.push_back(found == ids.end() ? (int) ids.size() : found->second); // undefined
+      }
+    }
+  }
+  firstProduction.push_back(productions.size());
+  firstProduction.push_back(productions.size()); // the undefined nonterminal has no productions
+  bodyStarts.push_back(bodies.size());
+
+  int nonterminalCount = firstProduction.size() - 1;
+  minimumTokens.push_back(vector<int>(nonterminalCount, kInfinite));
+  for (int height = 1; height <= maxDepth; height++) {
+    vector<int> row(nonterminalCount, kInfinite);
+    for (int nonterminal = 0; nonterminal < nonterminalCount; nonterminal++)
+      for (int p = firstProduction[nonterminal]; p < firstProduction[nonterminal + 1]; p++)
+        row[nonterminal] = min(row[nonterminal], fewestTokensOf(p, height - 1));
+    if (row == minimumTokens.back()) break;
+    minimumTokens.push_back(row);
+  }
+}
+
+int DerivationEnumerator::fewestTokens(int nonterminal, int height) const
+{
+  if (height <= 0) return kInfinite;
+  return minimumTokens[min(height, (int) minimumTokens.size() - 1)][nonterminal];
+}
+
+/**
+ * Returns the fewest terminals the specified production can yield
+ * if its nonterminals may each be at most height levels deep.
+ */
+
+int DerivationEnumerator::fewestTokensOf(int production, int height) const
+{
+  int total = 0;
+  for (int i = bodyStarts[production]; i < bodyStarts[production + 1]; i++)
+    total = addTokens(total, bodies[i] == -1 ? 1 : fewestTokens(bodies[i], height));
+  return total;
+}
+
+/**
+ * Returns true if and only if the specified alternative production
+ * for the nonterminal of the specified decision can be completed
+ * without breaking either bound, given everything else that's
+ * already been decided and everything still waiting to be expanded.
+ */
+
+bool DerivationEnumerator::isViable(const decision& choice, int alternative) const
+{
+  int height = maxDepth - choice.depth; // for the production's own nonterminals
+  int tokens = fewestTokensOf(firstProduction[choice.nonterminal] + alternative, height);
+  if (tokens == kInfinite) return false;
+  long long total = (long long) choice.tokens + choice.pending -
+    fewestTokens(choice.nonterminal, height + 1) + tokens;
+  return total <= maxTokens;
+}
+
+/**
+ * Method: replay
+ * --------------
+ * Expands the start symbol, following the recorded choices for as long
+ * as they last and taking the first viable alternative after that, and
+ * appends the sentence to out.  pending tracks the fewest terminals that
+ * the symbols not yet emitted or expanded could possibly yield, so a
+ * choice is viable exactly when tokens plus pending stays within bounds.
+ * Returns false (leaving out as it was) if a recorded choice is invalid.
+ */
+
+bool DerivationEnumerator::replay(OutputBuffer& out)
+{
+  uint64_t sentenceStart = out.getPosition();
+  bool first = true;
+  int tokens = 0;
+  int pending = fewestTokens(start, maxDepth);
+  stack.clear();
+  decisions.clear();
+
+  int nonterminal = start, depth = 1;
+  while (true) {
+    if (nonterminal != -1) {
+      decision choice = { nonterminal, depth, tokens, pending };
+      int count = firstProduction[nonterminal + 1] - firstProduction[nonterminal];
+      size_t k = decisions.size();
+      if (k == choices.size()) {
+        int alternative = 0;
+        while (alternative < count && !isViable(choice, alternative)) alternative++;
+        choices.push_back(alternative);
+      }
+      if (choices[k] < 0 || choices[k] >= count || !isViable(choice, choices[k])) {
+        out.rewind(sentenceStart);
+        return false;
+      }
+
+      int production = firstProduction[nonterminal] + choices[k];
+      int height = maxDepth - depth;
+      pending = pending - fewestTokens(nonterminal, height + 1) + fewestTokensOf(production, height);
+      decisions.push_back(choice);
+      frame pushed = { production, bodyStarts[production], depth };
+      stack.push_back(pushed);
+      nonterminal = -1;
+    }
+
+    if (stack.empty()) break;
+    frame& top = stack.back();
+    if (top.index == bodyStarts[top.production + 1]) {
+      stack.pop_back();
+      continue;
+    }
+
+    int symbol = bodies[top.index];
+    if (symbol != -1) {
+      nonterminal = symbol;
+      depth = top.depth + 1;
+    } else {
+      if (!first) out.put(' ');
+      out.append(productions[top.production]->begin()[top.index - bodyStarts[top.production]]);
+      first = false;
+      tokens++;
+      pending--;
+    }
+    top.index++;
+  }
+
+  return true;
+}
+
+/**
+ * Method: next
+ * ------------
+ * The first derivation needs no backtracking; every one after it
+ * bumps the latest choice that has a viable alternative left.
+ */
+
+bool DerivationEnumerator::next(OutputBuffer& out)
+{
+  if (start == -1 || fewestTokens(start, maxDepth) > maxTokens) return false;
+  if (!started) {
+    started = true;
+    choices.clear();
+    return replay(out);
+  }
+
+  for (int k = (int) decisions.size() - 1; k >= 0; k--) {
+    int count = firstProduction[decisions[k].nonterminal + 1] - firstProduction[decisions[k].nonterminal];
+    for (int alternative = choices[k] + 1; alternative < count; alternative++) {
+      if (!isViable(decisions[k], alternative)) continue;
+      choices.resize(k + 1);
+      choices[k] = alternative;
+      return replay(out);
+    }
+  }
+
+  decisions.clear(); // exhausted, and it stays that way
+  return false;
+}
+
+string DerivationEnumerator::getCheckpoint() const
+{
+  string checkpoint;
+  for (size_t i = 0; i < choices.size(); i++) {
+    if (i > 0) checkpoint += '.';
+    checkpoint += to_string(choices[i]);
+  }
+  return checkpoint;
+}
+
+/**
+ * Method: resume
+ * --------------
+ * The checkpoint is replayed (into a scratch buffer) to make sure
+ * it's a complete derivation within the bounds, which also leaves
+ * the decisions in place for next to backtrack through.
+ */
+
+bool DerivationEnumerator::resume(const string& checkpoint)
+{
+  choices.clear();
+  const char *curr = checkpoint.c_str();
+  while (*curr != '\0') {
+    char *end;
+    long choice = strtol(curr, &end, 10);
+    if (end == curr || choice < 0 || choice > INT_MAX || (*end != '.' && *end != '\0')) break;
+    choices.push_back(choice);
+    curr = *end == '.' ? end + 1 : end;
+  }
+
+  size_t parsed = choices.size();
+  OutputBuffer scratch;
+  started = *curr == '\0' && parsed > 0 && start != -1 && replay(scratch) && choices.size() == parsed;
+  if (!started) choices.clear();
+  return started;
+}
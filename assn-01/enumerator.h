@@ -0,0 +1,136 @@
+/**
+ * File: enumerator.h
+ * ------------------
+ * Defines the DerivationEnumerator class, which lists every derivation
+ * of a nonterminal, one at a time, subject to a bound on the nesting
+ * depth and a bound on the number of terminals.  Nothing beyond the
+ * current derivation is ever held in memory, so languages far too
+ * large to materialize can still be walked from one end to the other.
+ *
+ * Derivations are listed in a fixed order: a derivation is identified by
+ * the productions chosen, in the order a leftmost expansion chooses them,
+ * each numbered by its position in its Definition, and derivations come
+ * out in lexicographic order of those numbers.  That same list of numbers,
+ * written out as a checkpoint, is all that's needed to pick up where an
+ * earlier enumeration left off, so one enumeration can be split across
+ * several runs or processes.
+ */
+
+#ifndef __enumerator__
+#define __enumerator__
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "definition.h"
+#include "output.h"
+using namespace std;
+
+class DerivationEnumerator {
+
+ public:
+
+  /**
+   * Constructor: DerivationEnumerator
+   * ---------------------------------
+   * Prepares to enumerate the derivations of the specified nonterminal.
+   * Before anything is listed, the smallest number of terminals every
+   * nonterminal can yield within every depth is computed, so that the
+   * enumeration never wanders into a partial derivation that can't be
+   * completed within the bounds; each derivation costs time linear in
+   * its size, no matter how many dead ends the bounds create.
+   *
+   * @param grammar the grammar as read in from the text file, which must
+   *                outlive the enumerator.
+   * @param start the nonterminal whose derivations are listed.
+   * @param maxDepth the maximum number of nested expansions, counted the
+   *                 same way SentenceGenerator counts them.
+   * @param maxTokens the maximum number of terminals in a sentence.
+   */
+
+  DerivationEnumerator(const map<string_view, Definition>& grammar, string_view start,
+                       int maxDepth, int maxTokens);
+
+  /**
+   * Method: next
+   * ------------
+   * Appends the sentence of the next derivation to out, with exactly
+   * one space between consecutive terminals.
+   *
+   * @return true if there was another derivation, and false if
+   *         the enumeration is complete.
+   */
+
+  bool next(OutputBuffer& out);
+
+  /**
+   * Method: getCheckpoint
+   * ---------------------
+   * Returns a token identifying the derivation most recently returned
+   * by next: its production numbers, separated by periods.  The token
+   * is only meaningful to an enumerator with the same grammar and bounds.
+   */
+
+  string getCheckpoint() const;
+
+  /**
+   * Method: resume
+   * --------------
+   * Positions the enumerator just after the derivation identified by
+   * the specified checkpoint, so that next returns the one after it.
+   *
+   * @return false if the checkpoint doesn't identify a derivation
+   *         within the bounds, in which case the enumerator starts
+   *         over from the beginning.
+   */
+
+  bool resume(const string& checkpoint);
+
+ private:
+
+  /**
+   * Frames are as in SentenceGenerator, though productions are
+   * addressed by number, and the depth of each one is recorded.
+   */
+
+  struct frame {
+    int production;
+    int index;     // of the next symbol in the production
+    int depth;     // of the nonterminal the production expands
+  };
+
+  /**
+   * One decision per expanded nonterminal: what it was, and the
+   * state of the derivation just before its production was chosen,
+   * which is all it takes to judge its alternatives.
+   */
+
+  struct decision {
+    int nonterminal;
+    int depth;
+    int tokens;    // terminals emitted so far
+    int pending;   // the fewest terminals everything unexpanded can still yield
+  };
+
+  int maxDepth;
+  int maxTokens;
+  int start;
+  vector<const Production *> productions;
+  vector<int> firstProduction; // per nonterminal, plus a sentinel
+  vector<int> bodyStarts;      // per production, plus a sentinel
+  vector<int> bodies;          // the id of every nonterminal in a body, -1 for terminals
+  vector<vector<int> > minimumTokens; // [height][nonterminal]
+
+  bool started;
+  vector<int> choices;
+  vector<decision> decisions;
+  vector<frame> stack;
+
+  int fewestTokens(int nonterminal, int height) const;
+  int fewestTokensOf(int production, int height) const;
+  bool isViable(const decision& choice, int alternative) const;
+  bool replay(OutputBuffer& out);
+};
+
+#endif // ! __enumerator__
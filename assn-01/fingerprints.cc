@@ -0,0 +1,78 @@
+/**
+ * File: fingerprints.cc
+ * ---------------------
+ * Provides the implementation of the FingerprintTable class, an open
+ * addressing table with linear probing.  A slot is claimed by swapping
+ * a fingerprint into it atomically, and its index only ever decreases,
+ * so no insertion can undo another's.
+ */
+
+#include "fingerprints.h"
+
+/**
+ * At least 1 / kLoadDivisor of the slots are kept
+ * free, so that probes stay short.
+ */
+
+static const size_t kLoadDivisor = 3;
+
+FingerprintTable::FingerprintTable(size_t capacity)
+{
+  size_t slots = 16;
+  while (slots - slots / kLoadDivisor < capacity) slots *= 2;
+  mask = slots - 1;
+  fingerprints.reset(new atomic<uint64_t>[slots]);
+  indices.reset(new atomic<uint64_t>[slots]);
+  for (size_t i = 0; i < slots; i++) {
+    fingerprints[i].store(0, memory_order_relaxed);
+    indices[i].store(UINT64_MAX, memory_order_relaxed);
+  }
+}
+
+/**
+ * Static Method: getFingerprint
+ * -----------------------------
+ * FNV-1a over the bytes, followed by the murmur3 finalizer so
+ * every bit of the fingerprint depends on every byte.
+ */
+
+uint64_t FingerprintTable::getFingerprint(string_view sentence)
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < sentence.size(); i++) {
+    hash ^= (unsigned char) sentence[i];
+    hash *= 0x100000001b3ull;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ull;
+  hash ^= hash >> 33;
+  return hash == 0 ? 1 : hash;
+}
+
+void FingerprintTable::insert(uint64_t fingerprint, uint64_t index)
+{
+  size_t slot = fingerprint & mask;
+  while (true) {
+    uint64_t found = fingerprints[slot].load(memory_order_acquire);
+    if (found == 0 && fingerprints[slot].compare_exchange_strong(found, fingerprint, memory_order_acq_rel))
+      found = fingerprint;
+    if (found == fingerprint) break;
+    slot = (slot + 1) & mask;
+  }
+
+  uint64_t first = indices[slot].load(memory_order_relaxed);
+  while (index < first && !indices[slot].compare_exchange_weak(first, index, memory_order_acq_rel)) {}
+}
+
+uint64_t FingerprintTable::getFirstIndex(uint64_t fingerprint) const
+{
+  size_t slot = fingerprint & mask;
+  while (true) {
+    uint64_t found = fingerprints[slot].load(memory_order_acquire);
+    if (found == 0) return UINT64_MAX;
+    if (found == fingerprint) return indices[slot].load(memory_order_acquire);
+    slot = (slot + 1) & mask;
+  }
+}
@@ -0,0 +1,79 @@
+/**
+ * File: fingerprints.h
+ * --------------------
+ * Defines the FingerprintTable class, which remembers which sentences
+ * have been generated without remembering the sentences themselves:
+ * each one is reduced to a 64-bit fingerprint, and the table maps every
+ * fingerprint to the lowest index of any sentence that produced it.
+ * Any number of threads may insert at once without taking a lock.
+ *
+ * Two different sentences share a fingerprint with probability about
+ * n^2 / 2^65 over n sentences, which is negligible for any corpus that
+ * fits on a disk; when it does happen, the later sentence is taken for
+ * a repeat.
+ */
+
+#ifndef __fingerprints__
+#define __fingerprints__
+
+#include <atomic>
+#include <memory>
+#include <string_view>
+#include <stdint.h>
+using namespace std;
+
+class FingerprintTable {
+
+ public:
+
+  /**
+   * Constructor: FingerprintTable
+   * -----------------------------
+   * Constructs an empty table with room for the specified number of
+   * distinct fingerprints (and then some, so probes stay short).
+   * Inserting more than that many distinct fingerprints is an error.
+   */
+
+  FingerprintTable(size_t capacity);
+
+  /**
+   * Static Method: getFingerprint
+   * -----------------------------
+   * Returns the fingerprint of the specified sentence,
+   * which is never zero.
+   */
+
+  static uint64_t getFingerprint(string_view sentence);
+
+  /**
+   * Method: insert
+   * --------------
+   * Records that the sentence with the specified index has the
+   * specified fingerprint.  Safe to call from any number of threads.
+   */
+
+  void insert(uint64_t fingerprint, uint64_t index);
+
+  /**
+   * Method: getFirstIndex
+   * ---------------------
+   * Returns the lowest index inserted with the specified fingerprint
+   * so far, or UINT64_MAX if there hasn't been one.  Once every index
+   * below i has been inserted, a sentence i is the first of its kind
+   * exactly when this returns i.
+   */
+
+  uint64_t getFirstIndex(uint64_t fingerprint) const;
+
+ private:
+  size_t mask;                             // the number of slots, less one
+  unique_ptr<atomic<uint64_t>[]> fingerprints; // 0 marks an empty slot
+  unique_ptr<atomic<uint64_t>[]> indices;
+
+  // marked as private so tables aren't copied by accident
+  // (do NOT implement these).
+  FingerprintTable(const FingerprintTable& original);
+  FingerprintTable& operator=(const FingerprintTable& rhs);
+};
+
+#endif // ! __fingerprints__
@@ -0,0 +1,86 @@
+/**
+ * File: generator.cc
+ * ------------------
+ * Provides the implementation of the SentenceGenerator class.
+ * Each stack frame records how far we've gotten through one
+ * production, so the top of the stack always identifies the
+ * next symbol to be emitted or expanded.
+ */
+
+#include "generator.h"
+
+SentenceGenerator::SentenceGenerator(const Grammar& grammar, int maxDepth) :
+  grammar(grammar), maxDepth(maxDepth), profile(NULL) {}
+
+/**
+ * Method: generate
+ * ----------------
+ * Classic explicit-stack depth-first traversal.  Frames whose
+ * productions have been exhausted are popped, terminals are
+ * appended to out, and nonterminals push a frame for a randomly
+ * chosen production of their own.  When profiling, the profile
+ * hears about every push and pop.
+ */
+
+bool SentenceGenerator::generate(int start, RandomGenerator& random, OutputBuffer& out)
+{
+  uint64_t sentenceStart = out.getPosition();
+  bool first = true;
+
+  stack.clear();
+  if (!push(start, random)) return false;
+  if (profile != NULL) profile->enter(start, sentenceStart);
+  while (!stack.empty()) {
+    frame& top = stack.back();
+    if (top.curr == top.end) {
+      stack.pop_back();
+      if (profile != NULL) profile->exit(out.getPosition());
+      continue;
+    }
+
+    int symbol = *top.curr++;  // top may dangle after the push below
+    if (grammar.isNonterminal(symbol)) {
+      if (!push(symbol, random)) {
+        if (profile != NULL) profile->abandon();
+        out.rewind(sentenceStart);
+        return false;
+      }
+      if (profile != NULL) profile->enter(symbol, out.getPosition());
+    } else {
+      if (!first) out.put(' ');
+      out.append(grammar.getSymbolName(symbol));
+      first = false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Method: push
+ * ------------
+ * Chooses a production for the specified nonterminal and
+ * pushes a frame addressing its first symbol, unless doing
+ * so would break the depth limit or the nonterminal has
+ * nothing to expand to.
+ */
+
+bool SentenceGenerator::push(int nonterminal, RandomGenerator& random)
+{
+  int count = grammar.getProductionCount(nonterminal);
+  if (count == 0) {
+    errorMessage = string(grammar.getSymbolName(nonterminal)) + " is used but never defined.";
+    return false;
+  }
+
+  if ((int) stack.size() == maxDepth) {
+    errorMessage = "Expanding " + string(grammar.getSymbolName(nonterminal)) +
+      " would exceed the maximum expansion depth of " + to_string(maxDepth) + ".";
+    return false;
+  }
+
+  int production = grammar.chooseProduction(nonterminal, random);
+  frame pushed = { grammar.productionBegin(production), grammar.productionEnd(production) };
+  stack.push_back(pushed);
+  return true;
+}
@@ -0,0 +1,108 @@
+/**
+ * File: generator.h
+ * -----------------
+ * Defines the SentenceGenerator class, which expands a nonterminal
+ * of a compiled Grammar into a random sentence.  The expansion is
+ * driven by an explicit stack rather than by recursion, so deep
+ * grammars can't overflow the call stack, and terminals are appended
+ * directly into an OutputBuffer supplied by the client.
+ */
+
+#ifndef __generator__
+#define __generator__
+
+#include <string>
+#include <vector>
+#include "grammar.h"
+#include "output.h"
+#include "profiler.h"
+#include "random.h"
+using namespace std;
+
+class SentenceGenerator {
+
+ public:
+
+  /**
+   * The depth limit used when the client doesn't supply one.
+   */
+
+  static const int kDefaultMaxDepth = 1000;
+
+  /**
+   * Constructor: SentenceGenerator
+   * ------------------------------
+   * Constructs a generator layered over the specified grammar,
+   * which must outlive the generator.
+   *
+   * @param grammar the compiled grammar to generate from.
+   * @param maxDepth the maximum number of nested expansions that
+   *                 may be in progress at any one time.
+   */
+
+  SentenceGenerator(const Grammar& grammar, int maxDepth = kDefaultMaxDepth);
+
+  /**
+   * Method: generate
+   * ----------------
+   * Expands the specified nonterminal and appends the resulting
+   * sentence to out, with exactly one space between consecutive
+   * terminals.  Nothing already in out is overwritten, and no memory
+   * is allocated once the expansion stack (and out, if it grows) has
+   * grown to accommodate the largest sentence seen so far.
+   *
+   * @param start the id of the nonterminal to expand.
+   * @param random the source of randomness used to choose productions.
+   * @param out the buffer the sentence should be appended to.
+   * @return true if the sentence was generated, and false if
+   *         the depth limit was hit or an undefined nonterminal
+   *         was encountered.  In that case out is rewound to where
+   *         the sentence began (unless out already had to write part
+   *         of the sentence to its file descriptor), and
+   *         getErrorMessage explains what happened.
+   */
+
+  bool generate(int start, RandomGenerator& random, OutputBuffer& out);
+
+  /**
+   * Method: getErrorMessage
+   * -----------------------
+   * Returns a description of the most recent failure.
+   */
+
+  const string& getErrorMessage() const { return errorMessage; }
+
+  /**
+   * Method: setProfile
+   * ------------------
+   * Has every expansion recorded in the specified profile from now on,
+   * or stops recording if it's NULL (which is how the generator starts).
+   * The profile must outlive the generator or be replaced first.
+   */
+
+  void setProfile(ExpansionProfile *profile) { this->profile = profile; }
+
+  /**
+   * Method: getGrammar
+   * ------------------
+   * Returns the grammar the generator was constructed over.
+   */
+
+  const Grammar& getGrammar() const { return grammar; }
+
+ private:
+  struct frame {
+    const int32_t *curr;
+    const int32_t *end;
+  };
+
+  const Grammar& grammar;
+  int maxDepth;
+  ExpansionProfile *profile;
+  vector<frame> stack;
+  string errorMessage;
+
+  bool push(int nonterminal, RandomGenerator& random);
+};
+
+#endif // ! __generator__
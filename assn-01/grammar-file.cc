@@ -0,0 +1,34 @@
+/**
+ * File: grammar-file.cc
+ * ---------------------
+ * Provides the implementation of the GrammarFile class.
+ */
+
+#include "grammar-file.h"
+#include "tokenizer.h"
+
+/**
+ * Estimates how much arena space a grammar file of the specified
+ * size needs.  Each token becomes a string_view in the arena, and real
+ * grammars average well over four bytes per token (whitespace included)
+ * and several tokens per Production.  Getting it wrong isn't serious:
+ * an underestimate just costs another block or two.
+ */
+
+static size_t estimateArenaSize(size_t fileSize)
+{
+  return fileSize / 4 * sizeof(string_view) + fileSize / 8 * (sizeof(Production) + 2 * sizeof(int32_t));
+}
+
+GrammarFile::GrammarFile(const string& fileName) :
+  file(fileName), arena(estimateArenaSize(file.getSize()))
+{
+  if (!file.good()) return;
+  GrammarTokenizer tokenizer(file.getContents());
+  Definition::scratchSpace scratch;
+  while (true) {
+    if (!tokenizer.skipTo('{')) return;  // we encountered EOF before we saw a '{': no more productions!
+    Definition def(tokenizer, arena, scratch);
+    definitions.insert_or_assign(def.getNonterminal(), def);
+  }
+}
@@ -0,0 +1,70 @@
+/**
+ * File: grammar-file.h
+ * --------------------
+ * Defines the GrammarFile class, which owns everything a text grammar
+ * turns into when it's read: the mapped text itself, the Arena holding
+ * every Production and alias table, and the map of Definitions that
+ * view them.  It's shared by rsg and by the benchmark harness.
+ */
+
+#ifndef __grammar_file__
+#define __grammar_file__
+
+#include <map>
+#include <string>
+#include <string_view>
+#include "arena.h"
+#include "mapped-file.h"
+#include "definition.h"
+using namespace std;
+
+class GrammarFile {
+
+ public:
+
+  /**
+   * Constructor: GrammarFile
+   * ------------------------
+   * Maps the named file and populates the map with the collection
+   * of definitions that are spelled out in it.  The implementation
+   * is written under the assumption that the file is really a grammar
+   * file that's properly formatted.  You may assume that all grammars
+   * are in fact properly formatted.  The file is tokenized in one pass,
+   * and the arena is sized from the length of the file, so for all
+   * but the most unusual grammars it's a single allocation.
+   *
+   * @param fileName the name of the flat text grammar file.
+   */
+
+  GrammarFile(const string& fileName);
+
+  /**
+   * Predicate Method: good
+   * ----------------------
+   * Returns true if and only if the file could be mapped.
+   */
+
+  bool good() const { return file.good(); }
+
+  /**
+   * Method: getDefinitions
+   * ----------------------
+   * Returns the map from each nonterminal to its Definition.  Every
+   * key, Definition and Production refers into the GrammarFile, so
+   * none of them may be used once the GrammarFile is gone.
+   */
+
+  const map<string_view, Definition>& getDefinitions() const { return definitions; }
+
+ private:
+  MappedFile file;
+  Arena arena;
+  map<string_view, Definition> definitions;
+
+  // marked as private so the Definitions can't end up
+  // viewing another GrammarFile (do NOT implement these).
+  GrammarFile(const GrammarFile& original);
+  GrammarFile& operator=(const GrammarFile& rhs);
+};
+
+#endif // ! __grammar_file__
@@ -0,0 +1,332 @@
+/**
+ * File: grammar.cc
+ * ----------------
+ * Provides the implementation of the Grammar class.  Compilation
+ * is done in two passes over the Definitions: the first one interns
+ * every nonterminal (so they all receive the low ids), and the second
+ * one interns the terminals and lays out the flattened productions.
+ * The tables (and the perfect hash over the symbol names) are then
+ * copied into a single image, which is exactly what save writes and
+ * what the file constructor maps back in.
+ */
+
+#include <fstream>
+#include <unordered_map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "grammar.h"
+#include "output.h"
+#include "perfect-hash.h"
+
+const char Grammar::kSignature[8] = { 'R', 'S', 'G', 'C', '\r', '\n', '\x1a', '\n' };
+
+/**
+ * Returns the id of the specified symbol, handing out
+ * the next available id if it's never been seen before.
+ */
+
+static int intern(string_view symbol, unordered_map<string_view, int>& ids, vector<string_view>& names)
+{
+  unordered_map<string_view, int>::iterator found = ids.find(symbol);
+  if (found != ids.end()) return found->second;
+  int id = names.size();
+  names.push_back(symbol);
+  ids[symbol] = id;
+  return id;
+}
+
+/**
+ * Rounds the specified byte count up to the next
+ * multiple of four.
+ */
+
+static size_t align(size_t size)
+{
+  return (size + 3) & ~(size_t) 3;
+}
+
+/**
+ * Constructor: Grammar
+ * --------------------
+ * The map is sorted by nonterminal, so the ids handed out during
+ * the first pass are deterministic for a given grammar file, and the
+ * rest are handed out in order of first appearance after that.
+ */
+
+Grammar::Grammar(const map<string_view, Definition>& definitions) : header(NULL)
+{
+  unordered_map<string_view, int> ids;
+  ids.reserve(2 * definitions.size());
+  vector<string_view> symbolNames;
+  map<string_view, Definition>::const_iterator def;
+  for (def = definitions.begin(); def != definitions.end(); ++def)
+    intern(def->first, ids, symbolNames);
+  for (def = definitions.begin(); def != definitions.end(); ++def) {
+    for (Definition::const_iterator prod = def->second.begin(); prod != def->second.end(); ++prod) {
+      for (Production::const_iterator curr = prod->begin(); curr != prod->end(); ++curr) {
+        if (isNonterminalText(*curr)) intern(*curr, ids, symbolNames);
+      }
+    }
+  }
+
+  int nonterminalCount = symbolNames.size();
+  vector<const Definition *> byId(nonterminalCount, NULL);
+  for (def = definitions.begin(); def != definitions.end(); ++def)
+    byId[ids[def->first]] = &def->second;
+
+  vector<int32_t> firsts, starts, bodies, aliasColumns;
+  vector<uint32_t> coins;
+  for (int nonterminal = 0; nonterminal < nonterminalCount; nonterminal++) {
+    firsts.push_back(starts.size());
+    if (byId[nonterminal] == NULL) continue; // referenced, but never defined
+    const Definition& definition = *byId[nonterminal];
+    for (int i = 0; i < definition.getProductionCount(); i++) {
+      coins.push_back(definition.getThreshold(i));
+      aliasColumns.push_back(firsts.back() + definition.getAlias(i));
+    }
+    for (Definition::const_iterator prod = definition.begin(); prod != definition.end(); ++prod) {
+      starts.push_back(bodies.size());
+      for (Production::const_iterator curr = prod->begin(); curr != prod->end(); ++curr)
+        bodies.push_back(intern(*curr, ids, symbolNames));
+    }
+  }
+
+  firsts.push_back(starts.size());
+  starts.push_back(bodies.size());
+
+  vector<int32_t> textStarts(1, 0);
+  string text;
+  for (size_t i = 0; i < symbolNames.size(); i++) {
+    text += symbolNames[i];
+    textStarts.push_back(text.size());
+  }
+
+  uint32_t seed;
+  vector<uint32_t> buckets;
+  vector<int32_t> slotIds;
+  buildPerfectHash(symbolNames, seed, buckets, slotIds);
+
+  imageHeader layout;
+  memset(&layout, 0, sizeof(layout));
+  memcpy(layout.signature, kSignature, sizeof(kSignature));
+  layout.version = kVersion;
+  layout.byteOrder = kByteOrder;
+  layout.symbolCount = symbolNames.size();
+  layout.nonterminalCount = nonterminalCount;
+  layout.productionTotal = starts.size() - 1;
+  layout.symbolTotal = bodies.size();
+  layout.nameTotal = text.size();
+  layout.hashSeed = seed;
+  layout.bucketCount = buckets.size() / 2;
+
+  size_t offset = align(sizeof(imageHeader));
+  layout.firstProductionOffset = offset;
+  offset += firsts.size() * sizeof(int32_t);
+  layout.productionStartsOffset = offset;
+  offset += starts.size() * sizeof(int32_t);
+  layout.symbolsOffset = offset;
+  offset += bodies.size() * sizeof(int32_t);
+  layout.thresholdsOffset = offset;
+  offset += coins.size() * sizeof(uint32_t);
+  layout.aliasesOffset = offset;
+  offset += aliasColumns.size() * sizeof(int32_t);
+  layout.nameStartsOffset = offset;
+  offset += textStarts.size() * sizeof(int32_t);
+  layout.displacementsOffset = offset;
+  offset += buckets.size() * sizeof(uint32_t);
+  layout.slotsOffset = offset;
+  offset += slotIds.size() * sizeof(int32_t);
+  layout.namesOffset = offset;
+  offset += text.size();
+  if (align(offset) > UINT32_MAX) return; // offsets only grow, so every one fits if the last does
+  layout.imageSize = align(offset);
+
+  storage.assign(layout.imageSize / sizeof(int32_t), 0);
+  char *image = (char *) storage.data();
+  memcpy(image, &layout, sizeof(layout));
+  memcpy(image + layout.firstProductionOffset, firsts.data(), firsts.size() * sizeof(int32_t));
+  memcpy(image + layout.productionStartsOffset, starts.data(), starts.size() * sizeof(int32_t));
+  memcpy(image + layout.symbolsOffset, bodies.data(), bodies.size() * sizeof(int32_t));
+  memcpy(image + layout.thresholdsOffset, coins.data(), coins.size() * sizeof(uint32_t));
+  memcpy(image + layout.aliasesOffset, aliasColumns.data(), aliasColumns.size() * sizeof(int32_t));
+  memcpy(image + layout.nameStartsOffset, textStarts.data(), textStarts.size() * sizeof(int32_t));
+  memcpy(image + layout.displacementsOffset, buckets.data(), buckets.size() * sizeof(uint32_t));
+  memcpy(image + layout.slotsOffset, slotIds.data(), slotIds.size() * sizeof(int32_t));
+  memcpy(image + layout.namesOffset, text.data(), text.size());
+  attach(image, layout.imageSize);
+}
+
+/**
+ * Constructor: Grammar
+ * --------------------
+ * The mapping is kept alive for as long as the Grammar is,
+ * since every table points into it.
+ */
+
+Grammar::Grammar(const string& compiledFileName) : header(NULL)
+{
+  mapping.reset(new MappedFile(compiledFileName));
+  if (!mapping->good() || !attach(mapping->getData(), mapping->getSize())) mapping.reset();
+}
+
+/**
+ * Method: save
+ * ------------
+ * Other processes may have the file mapped, so it's never written in
+ * place: the image goes to a temporary file in the same directory,
+ * which replaces the original (by rename(2), atomically) only once
+ * it's been written in full.  Anyone still mapping the old file keeps
+ * seeing the old image.
+ */
+
+bool Grammar::save(const string& fileName) const
+{
+  string temporaryName = fileName + ".XXXXXX";
+  int fd = mkstemp(&temporaryName[0]);
+  if (fd == -1) return false;
+  bool written = fchmod(fd, 0644) == 0;
+  if (written) {
+    OutputBuffer out(fd);
+    out.append((const char *) header, header->imageSize);
+    written = out.flush() && fsync(fd) == 0;
+  }
+  if (close(fd) != 0) written = false;
+  if (written && rename(temporaryName.c_str(), fileName.c_str()) == 0) return true;
+  unlink(temporaryName.c_str());
+  return false;
+}
+
+bool Grammar::isCompiledFile(const string& fileName)
+{
+  char signature[sizeof(kSignature)];
+  ifstream infile(fileName.c_str(), ios::in | ios::binary);
+  infile.read(signature, sizeof(signature));
+  return infile.good() && memcmp(signature, kSignature, sizeof(kSignature)) == 0;
+}
+
+/**
+ * Method: lookup
+ * --------------
+ * The perfect hash sends every symbol in the grammar to its own slot,
+ * and any other string to some slot or other, so the name in the slot
+ * is compared to make sure it's the one asked for.
+ */
+
+int Grammar::lookup(string_view symbol) const
+{
+  if (header->symbolCount == 0) return -1;
+  uint64_t hash = hashName(symbol, header->hashSeed);
+  int id = slots[getPerfectSlot(hash, displacements, header->bucketCount, header->symbolCount)];
+  return getSymbolName(id) == symbol ? id : -1;
+}
+
+int Grammar::getDefinitionCount() const
+{
+  int count = 0;
+  for (int nonterminal = 0; nonterminal < header->nonterminalCount; nonterminal++)
+    if (getProductionCount(nonterminal) > 0) count++;
+  return count;
+}
+
+/**
+ * Static Method: isNonterminalText
+ * --------------------------------
+ * Same classification the original recursive generator used.
+ */
+
+bool Grammar::isNonterminalText(string_view token)
+{
+  return token.size() >= 2 && token[0] == '<' && token[token.size() - 1] == '>';
+}
+
+/**
+ * Returns true if and only if the specified array of count
+ * entries never decreases, starts at 0 and ends at last.
+ */
+
+static bool isRunBoundaries(const int32_t *array, int count, int32_t last)
+{
+  if (count <= 0 || array[0] != 0 || array[count - 1] != last) return false;
+  for (int i = 1; i < count; i++)
+    if (array[i] < array[i - 1]) return false;
+  return true;
+}
+
+/**
+ * Returns true if and only if every one of the count
+ * entries of the specified array is in [0, limit).
+ */
+
+static bool isWithin(const int32_t *array, int count, int32_t limit)
+{
+  for (int i = 0; i < count; i++)
+    if (array[i] < 0 || array[i] >= limit) return false;
+  return true;
+}
+
+/**
+ * Method: attach
+ * --------------
+ * Points the table pointers into the specified image, but only after
+ * confirming that the image is one we wrote and that no index in it
+ * could send the generator outside of the image.  A mapped file is
+ * untrusted input, after all.
+ */
+
+bool Grammar::attach(const void *image, size_t size)
+{
+  const char *base = (const char *) image;
+  const imageHeader *layout = (const imageHeader *) image;
+  if (size < sizeof(imageHeader) || memcmp(layout->signature, kSignature, sizeof(kSignature)) != 0 ||
+      layout->version != kVersion || layout->byteOrder != kByteOrder || layout->imageSize != size) return false;
+  if (layout->symbolCount < 0 || layout->nonterminalCount < 0 || layout->nonterminalCount > layout->symbolCount ||
+      layout->productionTotal < 0 || layout->symbolTotal < 0 || layout->nameTotal < 0 ||
+      layout->bucketCount == 0) return false;
+
+  struct { uint32_t offset; uint64_t bytes; } sections[] = {
+    { layout->firstProductionOffset, (layout->nonterminalCount + 1ull) * sizeof(int32_t) },
+    { layout->productionStartsOffset, (layout->productionTotal + 1ull) * sizeof(int32_t) },
+    { layout->symbolsOffset, (uint64_t) layout->symbolTotal * sizeof(int32_t) },
+    { layout->thresholdsOffset, (uint64_t) layout->productionTotal * sizeof(uint32_t) },
+    { layout->aliasesOffset, (uint64_t) layout->productionTotal * sizeof(int32_t) },
+    { layout->nameStartsOffset, (layout->symbolCount + 1ull) * sizeof(int32_t) },
+    { layout->displacementsOffset, 2ull * layout->bucketCount * sizeof(uint32_t) },
+    { layout->slotsOffset, (uint64_t) layout->symbolCount * sizeof(int32_t) },
+    { layout->namesOffset, (uint64_t) layout->nameTotal }
+  };
+  for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); i++) {
+    if (sections[i].offset % 4 != 0 || sections[i].offset + sections[i].bytes > size) return false;
+  }
+
+  const int32_t *firsts = (const int32_t *) (base + layout->firstProductionOffset);
+  const int32_t *starts = (const int32_t *) (base + layout->productionStartsOffset);
+  const int32_t *bodies = (const int32_t *) (base + layout->symbolsOffset);
+  const int32_t *columns = (const int32_t *) (base + layout->aliasesOffset);
+  const int32_t *textStarts = (const int32_t *) (base + layout->nameStartsOffset);
+  const int32_t *slotIds = (const int32_t *) (base + layout->slotsOffset);
+  if (!isRunBoundaries(firsts, layout->nonterminalCount + 1, layout->productionTotal) ||
+      !isRunBoundaries(starts, layout->productionTotal + 1, layout->symbolTotal) ||
+      !isRunBoundaries(textStarts, layout->symbolCount + 1, layout->nameTotal) ||
+      !isWithin(bodies, layout->symbolTotal, layout->symbolCount) ||
+      !isWithin(slotIds, layout->symbolCount, layout->symbolCount)) return false;
+  for (int nonterminal = 0; nonterminal < layout->nonterminalCount; nonterminal++) {
+    for (int production = firsts[nonterminal]; production < firsts[nonterminal + 1]; production++) {
+      if (columns[production] < firsts[nonterminal] || columns[production] >= firsts[nonterminal + 1]) return false;
+    }
+  }
+
+  header = layout;
+  firstProduction = firsts;
+  productionStarts = starts;
+  symbols = bodies;
+  thresholds = (const uint32_t *) (base + layout->thresholdsOffset);
+  aliases = columns;
+  nameStarts = textStarts;
+  displacements = (const uint32_t *) (base + layout->displacementsOffset);
+  slots = slotIds;
+  names = base + layout->namesOffset;
+  return true;
+}
@@ -0,0 +1,267 @@
+/**
+ * File: grammar.h
+ * ---------------
+ * Defines the abstraction for the Grammar class, which is
+ * the compiled form of a map<string_view, Definition>.  Every
+ * terminal and nonterminal is interned into a dense integer
+ * id, and every production is stored as a run of ids inside
+ * one flat array, so that expanding a nonterminal is nothing
+ * more than index arithmetic.
+ *
+ * All of the tables live in a single position-independent image
+ * (a header followed by arrays that refer to one another only
+ * through indices), so a compiled Grammar can be written to disk
+ * as is and later mapped straight back into memory.  The image
+ * includes a minimal perfect hash over the symbol names (see
+ * perfect-hash.h), so a symbol is found by name in constant time.
+ */
+
+#ifndef __grammar__
+#define __grammar__
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+#include "definition.h"
+#include "mapped-file.h"
+#include "random.h"
+using namespace std;
+
+class Grammar {
+
+ public:
+
+  /**
+   * Constructor: Grammar
+   * --------------------
+   * Compiles the specified collection of Definitions.  Symbol ids
+   * are handed out so that all nonterminals (including any that are
+   * referenced but never defined) come first, followed by all of
+   * the terminals.  An undefined nonterminal is recorded with
+   * zero productions.  The name of every symbol is copied into
+   * the Grammar, so the text the Definitions refer to may be
+   * released once the Grammar has been constructed.  good() reports
+   * whether the compiled image fit within the format's limits.
+   *
+   * @param definitions the grammar as read in from the text file.
+   */
+
+  Grammar(const map<string_view, Definition>& definitions);
+
+  /**
+   * Constructor: Grammar
+   * --------------------
+   * Maps a file previously written by save and uses it in place.
+   * Nothing is parsed; the header is checked and the tables are
+   * validated, and the Grammar is ready for use.  good() reports
+   * whether the file was a well-formed compiled grammar.
+   *
+   * @param compiledFileName the name of the file written by save.
+   */
+
+  Grammar(const string& compiledFileName);
+
+  /**
+   * Predicate Method: good
+   * ----------------------
+   * Returns true if and only if the Grammar is usable.  Compiling
+   * from Definitions fails only if the image would outgrow the 32-bit
+   * offsets in its header (4 GiB); loading may fail for many reasons.
+   */
+
+  bool good() const { return header != NULL; }
+
+  /**
+   * Method: save
+   * ------------
+   * Writes the compiled image to the named file.  The file is
+   * replaced all at once, so processes that have the old one mapped
+   * are unaffected, and a failed save leaves it as it was.
+   *
+   * @return true if and only if the entire image was written.
+   */
+
+  bool save(const string& fileName) const;
+
+  /**
+   * Static Method: isCompiledFile
+   * -----------------------------
+   * Returns true if the named file begins with the signature
+   * written by save, and false if it's (presumably) a text grammar.
+   */
+
+  static bool isCompiledFile(const string& fileName);
+
+  /**
+   * Method: lookup
+   * --------------
+   * Returns the id of the specified symbol, or -1 if the
+   * symbol doesn't appear anywhere in the grammar.  It costs
+   * one hash of the symbol and one string comparison, but
+   * expansion never needs it: it's for resolving start symbols
+   * and other names that come in from outside.
+   */
+
+  int lookup(string_view symbol) const;
+
+  /**
+   * Methods: getSymbolCount, getNonterminalCount, getProductionTotal, getSymbolTotal
+   * --------------------------------------------------------------------------------
+   * Self-explanatory sizes of the compiled tables.  The symbol
+   * total is the combined length of every production.
+   */
+
+  int getSymbolCount() const { return header->symbolCount; }
+  int getNonterminalCount() const { return header->nonterminalCount; }
+  int getProductionTotal() const { return header->productionTotal; }
+  int getSymbolTotal() const { return header->symbolTotal; }
+
+  /**
+   * Method: getDefinitionCount
+   * --------------------------
+   * Returns the number of nonterminals that have at least
+   * one production.
+   */
+
+  int getDefinitionCount() const;
+
+  /**
+   * Methods: isNonterminal, getSymbolName
+   * -------------------------------------
+   * Nonterminals occupy the ids [0, getNonterminalCount()), so
+   * classifying a symbol is a single integer comparison.  The
+   * name of a nonterminal includes the '<' and '>'.
+   */
+
+  bool isNonterminal(int symbol) const { return symbol < header->nonterminalCount; }
+  string_view getSymbolName(int symbol) const
+  { return string_view(names + nameStarts[symbol], nameStarts[symbol + 1] - nameStarts[symbol]); }
+
+  /**
+   * Methods: getFirstProduction, getProductionCount
+   * -----------------------------------------------
+   * The productions of nonterminal n are the ones numbered
+   * [getFirstProduction(n), getFirstProduction(n) + getProductionCount(n)).
+   */
+
+  int getFirstProduction(int nonterminal) const { return firstProduction[nonterminal]; }
+  int getProductionCount(int nonterminal) const
+  { return firstProduction[nonterminal + 1] - firstProduction[nonterminal]; }
+
+  /**
+   * Methods: productionBegin, productionEnd
+   * ---------------------------------------
+   * Returns pointers to the first and past-the-end symbol
+   * ids of the specified production.
+   */
+
+  const int32_t *productionBegin(int production) const
+  { return symbols + productionStarts[production]; }
+  const int32_t *productionEnd(int production) const
+  { return symbols + productionStarts[production + 1]; }
+
+  /**
+   * Method: getProductionOffset
+   * ---------------------------
+   * Returns the position of the specified production's first symbol
+   * among all getSymbolTotal() of them, so that clients can keep their
+   * own per-symbol tables alongside the Grammar's.
+   */
+
+  int getProductionOffset(int production) const { return productionStarts[production]; }
+
+  /**
+   * Method: chooseProduction
+   * ------------------------
+   * Returns the number of a randomly chosen production of the
+   * specified nonterminal, respecting the weights given in the
+   * grammar file.  Each nonterminal's productions form one alias
+   * table, so the cost is one uniform draw plus, only for weighted
+   * nonterminals, one biased coin flip.  The nonterminal must have
+   * at least one production.
+   */
+
+  int chooseProduction(int nonterminal, RandomGenerator& random) const;
+
+  /**
+   * Static Method: isNonterminalText
+   * --------------------------------
+   * Returns true if and only if the specified token is
+   * delimited by '<' and '>'.
+   */
+
+  static bool isNonterminalText(string_view token);
+
+ private:
+
+  /**
+   * The image begins with this header.  Every offset is a byte
+   * offset from the start of the image, and every section starts
+   * on a four-byte boundary.
+   */
+
+  struct imageHeader {
+    char signature[8];
+    uint32_t version;
+    uint32_t byteOrder;        // kByteOrder as written by the compiling machine
+    uint32_t imageSize;
+    int32_t symbolCount;
+    int32_t nonterminalCount;
+    int32_t productionTotal;
+    int32_t symbolTotal;       // length of the flattened production bodies
+    int32_t nameTotal;         // bytes of symbol text
+    uint32_t firstProductionOffset;
+    uint32_t productionStartsOffset;
+    uint32_t symbolsOffset;
+    uint32_t thresholdsOffset;
+    uint32_t aliasesOffset;
+    uint32_t nameStartsOffset;
+    uint32_t hashSeed;
+    uint32_t bucketCount;
+    uint32_t displacementsOffset;
+    uint32_t slotsOffset;
+    uint32_t namesOffset;
+  };
+
+  static const char kSignature[8];
+  static const uint32_t kVersion = 3;
+  static const uint32_t kByteOrder = 0x01020304;
+
+  vector<int32_t> storage;         // owns the image when compiled in memory
+  unique_ptr<MappedFile> mapping;  // owns the image when loaded from disk
+
+  const imageHeader *header;
+  const int32_t *firstProduction;  // nonterminalCount + 1 entries
+  const int32_t *productionStarts; // one entry per production, plus a sentinel
+  const int32_t *symbols;          // every production body, back to back
+  const uint32_t *thresholds;      // per production, see alias.h
+  const int32_t *aliases;          // per production, as production numbers
+  const int32_t *nameStarts;       // symbolCount + 1 entries into names
+  const uint32_t *displacements;   // per bucket of the perfect hash, a (d0, d1) pair
+  const int32_t *slots;            // per slot of the perfect hash, the symbol id
+  const char *names;
+
+  bool attach(const void *image, size_t size);
+
+  // marked as private so Grammars can't be copy constructed or reassigned,
+  // which would leave the table pointers addressing someone else's image.
+  Grammar(const Grammar& original);
+  Grammar& operator=(const Grammar& rhs);
+};
+
+/**
+ * Called once per expansion, so it's defined here where it can be inlined.
+ */
+
+inline int Grammar::chooseProduction(int nonterminal, RandomGenerator& random) const
+{
+  int production = firstProduction[nonterminal] + random.getRandomInteger(0, getProductionCount(nonterminal) - 1);
+  if (aliases[production] != production && (uint32_t) random.getRandomBits() >= thresholds[production])
+    production = aliases[production];
+  return production;
+}
+
+#endif // ! __grammar__
@@ -0,0 +1,48 @@
+/**
+ * File: mapped-file.cc
+ * --------------------
+ * Provides the implementation of the MappedFile class.  This is
+ * the same UNIXy open/fstat/mmap sequence used to layer the imdb
+ * over its data files.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "mapped-file.h"
+
+/**
+ * The descriptor can be closed as soon as the mapping
+ * exists, since the mapping holds its own reference to
+ * the file.
+ */
+
+MappedFile::MappedFile(const string& fileName) : data(NULL), size(0), isGood(false)
+{
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd == -1) return;
+
+  struct stat stats;
+  if (fstat(fd, &stats) == 0) {
+    size = stats.st_size;
+    if (size == 0) {
+      isGood = true;
+    } else {
+      void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping != MAP_FAILED) {
+        madvise(mapping, size, MADV_SEQUENTIAL); // we read it front to back, once
+        data = (const char *) mapping;
+        isGood = true;
+      }
+    }
+  }
+
+  close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+  if (data != NULL) munmap((void *) data, size);
+}
@@ -0,0 +1,71 @@
+/**
+ * File: mapped-file.h
+ * -------------------
+ * Defines the MappedFile class, which makes the contents
+ * of a file look like a read-only array of bytes in RAM.
+ * Everything parsed out of the file can then refer back
+ * into the mapping instead of copying the text.
+ */
+
+#ifndef __mapped_file__
+#define __mapped_file__
+
+#include <string>
+#include <string_view>
+using namespace std;
+
+class MappedFile {
+
+ public:
+
+  /**
+   * Constructor: MappedFile
+   * -----------------------
+   * Maps the entire contents of the named file into memory.
+   * An empty file is perfectly legal, and is presented as
+   * a zero-length array.
+   *
+   * @param fileName the name of the file to be mapped.
+   */
+
+  MappedFile(const string& fileName);
+
+  /**
+   * Predicate Method: good
+   * ----------------------
+   * Returns true if and only if the file was opened and mapped without incident.
+   */
+
+  bool good() const { return isGood; }
+
+  /**
+   * Methods: getData, getSize, getContents
+   * --------------------------------------
+   * Provide access to the mapped bytes, which remain valid
+   * for as long as the MappedFile itself is alive.
+   */
+
+  const char *getData() const { return data; }
+  size_t getSize() const { return size; }
+  string_view getContents() const { return string_view(data, size); }
+
+  /**
+   * Destructor: ~MappedFile
+   * -----------------------
+   * Unmaps the file.
+   */
+
+  ~MappedFile();
+
+ private:
+  const char *data;
+  size_t size;
+  bool isGood;
+
+  // marked as private so the mapping can't be aliased and
+  // released twice (do NOT implement these).
+  MappedFile(const MappedFile& original);
+  MappedFile& operator=(const MappedFile& rhs);
+};
+
+#endif // ! __mapped_file__
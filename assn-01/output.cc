@@ -0,0 +1,116 @@
+/**
+ * File: output.cc
+ * ---------------
+ * Provides the implementation of the OutputBuffer class.
+ */
+
+#include <algorithm>
+#include <errno.h>
+#include <new>
+#include <stdlib.h>
+#include <unistd.h>
+#include "output.h"
+
+/**
+ * The first allocation made by a growable buffer.
+ */
+
+static const size_t kInitialGrowCapacity = 4096;
+
+OutputBuffer::OutputBuffer(int fd, size_t capacity) :
+  mode(kDrain), fd(fd), flushed(0), errorNumber(0)
+{
+  if (capacity == 0) capacity = 1;
+  begin = end = (char *) malloc(capacity);
+  if (begin == NULL) throw bad_alloc();
+  limit = begin + capacity;
+}
+
+OutputBuffer::OutputBuffer(char *region, size_t size) :
+  mode(kRegion), fd(-1), begin(region), end(region), limit(region + size), flushed(0), errorNumber(0) {}
+
+OutputBuffer::OutputBuffer() :
+  mode(kGrow), fd(-1), begin(NULL), end(NULL), limit(NULL), flushed(0), errorNumber(0) {}
+
+OutputBuffer::~OutputBuffer()
+{
+  flush();
+  if (mode != kRegion) free(begin);
+}
+
+bool OutputBuffer::flush()
+{
+  if (mode != kDrain || end == begin) return good();
+  writeOut(begin, end - begin);
+  flushed += end - begin;
+  end = begin;
+  return good();
+}
+
+bool OutputBuffer::rewind(uint64_t position)
+{
+  if (position < flushed || position > getPosition()) return false;
+  end = begin + (position - flushed);
+  return true;
+}
+
+void OutputBuffer::reserve(size_t capacity)
+{
+  if (mode != kGrow || capacity <= (size_t) (limit - begin)) return;
+  size_t used = end - begin;
+  char *grown = (char *) realloc(begin, capacity);
+  if (grown == NULL) throw bad_alloc(); // begin is still valid, and freed by the destructor
+  begin = grown;
+  end = begin + used;
+  limit = begin + capacity;
+}
+
+/**
+ * Method: appendSlow
+ * ------------------
+ * Handles an append that doesn't fit.  A draining buffer flushes, and
+ * then either copies the text in or, if the text is at least as large
+ * as the buffer, writes it straight out without copying it at all.
+ */
+
+void OutputBuffer::appendSlow(const char *text, size_t length)
+{
+  if (mode == kDrain) {
+    flush();
+    if (length < (size_t) (limit - begin)) {
+      memcpy(end, text, length);
+      end += length;
+    } else {
+      writeOut(text, length);
+      flushed += length;
+    }
+  } else if (mode == kGrow) {
+    reserve(max(max(kInitialGrowCapacity, 2 * (size_t) (limit - begin)), size() + length));
+    memcpy(end, text, length);
+    end += length;
+  } else {
+    errorNumber = ENOSPC; // a fixed region can't make room
+  }
+}
+
+/**
+ * Method: writeOut
+ * ----------------
+ * write(2) may write fewer bytes than asked, or be interrupted,
+ * so keep at it until everything is out or a real error occurs.
+ */
+
+bool OutputBuffer::writeOut(const char *text, size_t length)
+{
+  while (length > 0 && good()) {
+    ssize_t written = write(fd, text, length);
+    if (written < 0) {
+      if (errno != EINTR) errorNumber = errno;
+      continue;
+    }
+    text += written;
+    length -= written;
+  }
+
+  return good();
+}
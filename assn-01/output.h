@@ -0,0 +1,189 @@
+/**
+ * File: output.h
+ * --------------
+ * Defines the OutputBuffer class, a large reusable byte buffer that
+ * generated text is appended to directly.  An OutputBuffer either
+ * drains into a file descriptor with write(2) in big chunks, fills a
+ * fixed memory region supplied by the client, or simply grows in
+ * memory until the client takes the bytes out.
+ */
+
+#ifndef __output__
+#define __output__
+
+#include <string_view>
+#include <stdint.h>
+#include <string.h>
+using namespace std;
+
+class OutputBuffer {
+
+ public:
+
+  /**
+   * The buffer size used when writing to a file
+   * descriptor and the client doesn't supply one.
+   */
+
+  static const size_t kDefaultCapacity = 1 << 20;
+
+  /**
+   * Constructor: OutputBuffer
+   * -------------------------
+   * Constructs a buffer that drains into the specified file descriptor
+   * whenever it fills, so memory use never exceeds the capacity no
+   * matter how much text is appended.  The descriptor isn't closed by
+   * the OutputBuffer.
+   *
+   * @param fd the open file descriptor to write to.
+   * @param capacity the number of bytes buffered between writes.
+   */
+
+  OutputBuffer(int fd, size_t capacity = kDefaultCapacity);
+
+  /**
+   * Constructor: OutputBuffer
+   * -------------------------
+   * Constructs a buffer that writes into the client's memory region
+   * and never anywhere else.  Once the region is full, further text
+   * is dropped and good() returns false.
+   *
+   * @param region the start of the memory to be written.
+   * @param size the number of bytes available in the region.
+   */
+
+  OutputBuffer(char *region, size_t size);
+
+  /**
+   * Constructor: OutputBuffer
+   * -------------------------
+   * Constructs a buffer that holds everything appended to it in
+   * memory, growing as needed, until the client calls clear.
+   */
+
+  OutputBuffer();
+
+  /**
+   * Destructor: ~OutputBuffer
+   * -------------------------
+   * Writes out anything still buffered (if there's a file
+   * descriptor to write it to) and releases the buffer.
+   */
+
+  ~OutputBuffer();
+
+  /**
+   * Methods: append, put
+   * --------------------
+   * Appends the specified bytes (or the single specified character).
+   * The common case, where the bytes fit, is an inlined memcpy.
+   */
+
+  void append(const char *text, size_t length);
+  void append(string_view text) { append(text.data(), text.size()); }
+  void put(char ch);
+
+  /**
+   * Method: flush
+   * -------------
+   * Writes everything buffered to the file descriptor.  A buffer with
+   * no file descriptor has nowhere to flush to, so this does nothing.
+   *
+   * @return good().
+   */
+
+  bool flush();
+
+  /**
+   * Predicate Method: good
+   * ----------------------
+   * Returns false once a write has failed or a fixed
+   * memory region has overflowed.
+   */
+
+  bool good() const { return errorNumber == 0; }
+
+  /**
+   * Method: getErrorNumber
+   * ----------------------
+   * Returns the errno of the failed write, or ENOSPC
+   * if a fixed memory region overflowed.
+   */
+
+  int getErrorNumber() const { return errorNumber; }
+
+  /**
+   * Methods: data, size, clear
+   * --------------------------
+   * Provide access to the bytes currently held in memory (everything
+   * appended since the last flush or clear), and discard them.
+   */
+
+  const char *data() const { return begin; }
+  size_t size() const { return end - begin; }
+  void clear() { end = begin; }
+
+  /**
+   * Method: reserve
+   * ---------------
+   * Makes room for at least the specified number of bytes up front,
+   * so a growable buffer needn't reallocate as it fills.  Buffers of
+   * the other two kinds have a fixed capacity and ignore this.
+   */
+
+  void reserve(size_t capacity);
+
+  /**
+   * Methods: getPosition, rewind
+   * ----------------------------
+   * getPosition returns the total number of bytes appended so far.
+   * rewind discards everything appended after the specified position,
+   * provided none of it has been written out yet.
+   *
+   * @return true if the bytes were discarded, and false if some
+   *         of them had already been flushed.
+   */
+
+  uint64_t getPosition() const { return flushed + (end - begin); }
+  bool rewind(uint64_t position);
+
+ private:
+  enum { kDrain, kRegion, kGrow } mode;
+  int fd;
+  char *begin;
+  char *end;
+  char *limit;
+  uint64_t flushed;   // bytes that have left the buffer for good
+  int errorNumber;
+
+  void appendSlow(const char *text, size_t length);
+  bool writeOut(const char *text, size_t length);
+
+  // marked as private so two OutputBuffers can't share and
+  // release the same storage (do NOT implement these).
+  OutputBuffer(const OutputBuffer& original);
+  OutputBuffer& operator=(const OutputBuffer& rhs);
+};
+
+/**
+ * Both appends happen once per terminal, so they're defined here where
+ * they can be inlined.  Anything unusual is handled by appendSlow.
+ */
+
+inline void OutputBuffer::append(const char *text, size_t length)
+{
+  if (length <= (size_t) (limit - end)) {
+    memcpy(end, text, length);
+    end += length;
+  } else {
+    appendSlow(text, length);
+  }
+}
+
+inline void OutputBuffer::put(char ch)
+{
+  if (end != limit) *end++ = ch;
+  else appendSlow(&ch, 1);
+}
+
+#endif // ! __output__
@@ -0,0 +1,126 @@
+/**
+ * File: perfect-hash.cc
+ * ---------------------
+ * Provides the implementation of buildPerfectHash.  Buckets are placed
+ * largest first, while most slots are still free.  By the time the
+ * single-name buckets are placed, the table is nearly full, but d1
+ * alone can steer a lone name to any slot, so each of them is simply
+ * given one of the free slots that remain, rather than searched for.
+ */
+
+#include <algorithm>
+#include "perfect-hash.h"
+
+/**
+ * The average number of names per bucket.  More names per bucket
+ * means a smaller displacement table but a slower build.
+ */
+
+static const uint32_t kNamesPerBucket = 2;
+
+/**
+ * The number of values of d0 tried for one bucket (each with
+ * every value of d1) before the seed is given up on.
+ */
+
+static const uint32_t kMaxFirstDisplacements = 64;
+
+/**
+ * Places the buckets order[k] onwards, which hold at most one name each,
+ * in the slots that are still free, by solving for d1 with d0 = 0.
+ */
+
+static void placeSingles(const vector<uint64_t>& hashes, const vector<uint32_t>& members,
+                         const vector<uint32_t>& bucketStarts, const vector<uint32_t>& order, uint32_t k,
+                         vector<uint32_t>& displacements, vector<int32_t>& slots)
+{
+  uint32_t n = slots.size();
+  uint32_t free = 0;
+  for (; k < order.size(); k++) {
+    uint32_t bucket = order[k];
+    if (bucketStarts[bucket] == bucketStarts[bucket + 1]) break;
+    while (slots[free] != -1) free++;
+    uint32_t name = members[bucketStarts[bucket]];
+    uint32_t f1 = (uint32_t) hashes[name] % n;
+    displacements[2 * bucket] = 0;
+    displacements[2 * bucket + 1] = (free + n - f1) % n;
+    slots[free] = name;
+  }
+}
+
+/**
+ * Tries to place every bucket using hashes computed with the specified
+ * seed, and returns false if some bucket can't be placed.
+ */
+
+static bool placeBuckets(const vector<string_view>& names, uint32_t seed, uint32_t bucketCount,
+                         vector<uint32_t>& displacements, vector<int32_t>& slots)
+{
+  uint32_t n = names.size();
+  vector<uint64_t> hashes(n);
+  vector<uint32_t> bucketStarts(bucketCount + 1, 0);
+  for (uint32_t i = 0; i < n; i++) {
+    hashes[i] = hashName(names[i], seed);
+    bucketStarts[getPerfectBucket(hashes[i], bucketCount) + 1]++;
+  }
+  for (uint32_t b = 0; b < bucketCount; b++) bucketStarts[b + 1] += bucketStarts[b];
+
+  vector<uint32_t> members(n), filled(bucketStarts.begin(), bucketStarts.end() - 1);
+  for (uint32_t i = 0; i < n; i++)
+    members[filled[getPerfectBucket(hashes[i], bucketCount)]++] = i;
+
+  vector<uint32_t> order(bucketCount);
+  for (uint32_t b = 0; b < bucketCount; b++) order[b] = b;
+  stable_sort(order.begin(), order.end(), [&bucketStarts](uint32_t a, uint32_t b) {
+    return bucketStarts[a + 1] - bucketStarts[a] > bucketStarts[b + 1] - bucketStarts[b];
+  });
+
+  displacements.assign(2 * bucketCount, 0);
+  slots.assign(n, -1);
+  vector<uint32_t> bases;
+  for (uint32_t k = 0; k < bucketCount; k++) {
+    uint32_t bucket = order[k];
+    uint32_t first = bucketStarts[bucket], last = bucketStarts[bucket + 1];
+    if (first == last) break; // the rest are empty as well
+    if (last - first == 1) {
+      placeSingles(hashes, members, bucketStarts, order, k, displacements, slots);
+      return true;
+    }
+
+    bool placed = false;
+    for (uint32_t d0 = 0; d0 < min(n, kMaxFirstDisplacements) && !placed; d0++) {
+      bases.clear();  // each name's slot with d1 = 0, so d1 just rotates them
+      for (uint32_t m = first; m < last; m++) {
+        uint64_t hash = hashes[members[m]];
+        bases.push_back(((uint32_t) hash % n + (uint64_t) d0 * ((uint32_t) (hash >> 32) % n)) % n);
+      }
+      for (uint32_t d1 = 0; d1 < n && !placed; d1++) {
+        size_t claimed = 0;
+        for (; claimed < bases.size(); claimed++) {
+          uint32_t slot = bases[claimed] + d1 < n ? bases[claimed] + d1 : bases[claimed] + d1 - n;
+          if (slots[slot] != -1) break;
+          slots[slot] = members[first + claimed]; // tentatively, so the bucket can't collide with itself
+        }
+        placed = claimed == bases.size();
+        if (placed) {
+          displacements[2 * bucket] = d0;
+          displacements[2 * bucket + 1] = d1;
+        } else {
+          for (size_t t = 0; t < claimed; t++)
+            slots[bases[t] + d1 < n ? bases[t] + d1 : bases[t] + d1 - n] = -1;
+        }
+      }
+    }
+    if (!placed) return false;
+  }
+
+  return true;
+}
+
+void buildPerfectHash(const vector<string_view>& names, uint32_t& seed,
+                      vector<uint32_t>& displacements, vector<int32_t>& slots)
+{
+  uint32_t bucketCount = max<uint32_t>(1, (names.size() + kNamesPerBucket - 1) / kNamesPerBucket);
+  seed = 0;
+  while (!placeBuckets(names, seed, bucketCount, displacements, slots)) seed++;
+}
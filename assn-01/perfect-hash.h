@@ -0,0 +1,97 @@
+/**
+ * File: perfect-hash.h
+ * --------------------
+ * Defines a minimal perfect hash over a fixed set of names, built by
+ * the compress, hash and displace (CHD) method.  Every name is hashed
+ * once, into a bucket and a pair of values (f1, f2), and each bucket
+ * carries a displacement (d0, d1) chosen so that the slots
+ *
+ *     (f1 + d0 * f2 + d1) mod n
+ *
+ * of the names in it land on slots no other bucket has claimed.  With
+ * n slots for n names, the slot of a name is its unique index, so
+ * resolving a name costs one hash and (to reject names outside the
+ * set) one comparison.  The tables are plain arrays of 32-bit
+ * integers, so they can live inside a compiled grammar image.
+ */
+
+#ifndef __perfect_hash__
+#define __perfect_hash__
+
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+using namespace std;
+
+/**
+ * Function: hashName
+ * ------------------
+ * Hashes the specified name (FNV-1a, followed by a 64-bit
+ * finalizer so every bit depends on every byte) under the
+ * specified seed.
+ */
+
+inline uint64_t hashName(string_view name, uint32_t seed)
+{
+  uint64_t hash = 0xcbf29ce484222325ull ^ seed;
+  for (size_t i = 0; i < name.size(); i++) {
+    hash ^= (unsigned char) name[i];
+    hash *= 0x100000001b3ull;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ull;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+/**
+ * Function: getPerfectBucket
+ * --------------------------
+ * Returns the bucket of the name with the specified hash, drawn
+ * from the high bits of a multiplicative remix of the hash, so it's
+ * independent of f1 and f2, which use the hash's low and high halves.
+ */
+
+inline uint32_t getPerfectBucket(uint64_t hash, uint32_t bucketCount)
+{
+  return (uint32_t) ((hash * 0x9e3779b97f4a7c15ull) >> 32) % bucketCount;
+}
+
+/**
+ * Function: getPerfectSlot
+ * ------------------------
+ * Returns the slot in [0, slotCount) for the name with the specified
+ * hash.  The displacement table holds a (d0, d1) pair per bucket; any
+ * values at all (even corrupt ones) still produce a slot in range.
+ */
+
+inline uint32_t getPerfectSlot(uint64_t hash, const uint32_t *displacements,
+                               uint32_t bucketCount, uint32_t slotCount)
+{
+  uint32_t bucket = getPerfectBucket(hash, bucketCount);
+  uint64_t f1 = (uint32_t) hash % slotCount;
+  uint64_t f2 = (uint32_t) (hash >> 32) % slotCount;
+  uint64_t d0 = displacements[2 * bucket], d1 = displacements[2 * bucket + 1];
+  return (f1 + d0 % slotCount * f2 + d1) % slotCount;
+}
+
+/**
+ * Function: buildPerfectHash
+ * --------------------------
+ * Builds a minimal perfect hash over the specified names, which must
+ * be distinct.  A bucket that can't be placed within a bounded number
+ * of displacements makes the whole build start over with a new seed,
+ * which in practice happens rarely, if ever.
+ *
+ * @param names the names to be hashed.
+ * @param seed set to the seed the tables were built with.
+ * @param displacements set to the (d0, d1) pair of every bucket.
+ * @param slots set to the index (into names) of the name in every slot.
+ */
+
+void buildPerfectHash(const vector<string_view>& names, uint32_t& seed,
+                      vector<uint32_t>& displacements, vector<int32_t>& slots);
+
+#endif // ! __perfect_hash__
@@ -3,18 +3,36 @@
  * -------------------
  * Provides the implementation of the Production class, which
  * is simply a wrapper for the sequence of items (where items are terminals
- * or nonterminals).  It also completes the implementation of the ifstream
+ * or nonterminals).  It also completes the implementation of the GrammarTokenizer
  * constructor, which was really the only thing missing from the .h
  */
 
+#include <charconv>
+#include <cmath>
 #include "production.h"
 
+/**
+ * Returns true if the token has the form [w] for some finite,
+ * non-negative number w, in which case w is stored in weight.
+ */
+
+static bool parseWeight(string_view token, double& weight)
+{
+  if (token.size() < 3 || token.front() != '[' || token.back() != ']') return false;
+  double parsed;
+  const char *end = token.data() + token.size() - 1;
+  from_chars_result result = from_chars(token.data() + 1, end, parsed);
+  if (result.ec != errc() || result.ptr != end || !isfinite(parsed) || parsed < 0) return false;
+  weight = parsed;
+  return true;
+}
+
 /**
  * Constructor Implementation: Production
  * --------------------------------------
  * Constructor that initializes the Production based
- * on the content of a file.  infile is presumably
- * positioned at the beginning of a line of textual
+ * on the text addressed by the tokenizer.  The tokenizer is
+ * presumably positioned at the beginning of a line of textual
  * data representing a CFG production such that the
  * expansion is terminated by a semicolon.  The assumption
  * made is that nonterminals (strings that also can expand
@@ -22,21 +40,20 @@
  * that no whitespace appears in between '<' and '>'.  The implementation
  * will also read the whitespace and the '\n' appearing after the 
  * semicolon and discard it.
- *
- * You are more than welcome to update this implementation to do
- * something else if you'd like to.
  */
 
-Production::Production(ifstream& infile)  // phrases is constructed, size is 0
+Production::Production(GrammarTokenizer& tokenizer, Arena& arena, vector<string_view>& scratch) : weight(1)
 {
+  scratch.clear();
+  bool first = true;
   while (true) {
-    string token;
-    infile >> token;  // ignores whitespace by default
-    if (token == ";") break;
-    phrases.push_back(token);
+    string_view token = tokenizer.nextToken();  // ignores whitespace by default
+    if (token.empty() || token == ";") break;   // empty means we ran out of text
+    if (!first || !parseWeight(token, weight)) scratch.push_back(token);
+    first = false;
   }
   
-  string uselessText;
-  getline(infile, uselessText); // read everything else as if it's important
-  // oh, no it's not.. it's useless.. but we're glad it's been pulled from the stream..
+  tokenizer.skipLine(); // everything else on the line is useless
+  phrases = arena.copy(scratch.data(), scratch.size());
+  count = scratch.size();
 }
@@ -3,16 +3,21 @@
  * ------------------
  * Defines the abstraction for the Production class, 
  * which encapsulates the functionality needed to store
- * a contiguous list of strings.
+ * a contiguous list of strings.  The strings are views
+ * into the text of the grammar file, and the list of them
+ * lives in an Arena, so the Production itself is just a
+ * small view that's cheap to copy.  Both the text and the
+ * Arena must outlive the Production.
  */
  
 #ifndef __production__
 #define __production__
 
 #include <vector>
-#include <fstream>
-#include <iostream>
 #include <string>
+#include <string_view>
+#include "arena.h"
+#include "tokenizer.h"
 using namespace std;
 
 class Production {
@@ -24,8 +29,8 @@ class Production {
    * a Production instance.
    */
   
-  typedef vector<string>::iterator iterator;
-  typedef vector<string>::const_iterator const_iterator;
+  typedef const string_view *iterator;
+  typedef const string_view *const_iterator;
   
  public:
   
@@ -44,36 +49,67 @@ class Production {
    * have a default constructor.
    */
   
-  Production() {}
+  Production() : phrases(NULL), count(0), weight(1) {}
   
   /**
-   * ifstream Constructor: Production
-   * --------------------------------
-   * Initializes the Production based on the contents
-   * of the specified ifstream.  The ifstream is presumably
-   * positions at the start of a line that houses a production.
+   * GrammarTokenizer Constructor: Production
+   * ----------------------------------------
+   * Initializes the Production based on the text addressed
+   * by the specified tokenizer.  The tokenizer is presumably
+   * positioned at the start of a line that houses a production.
    * Leading whitespace is discarded, the series of terminals and
    * non-terminals are read in until a semicolon is consumed, and
-   * the the rest of the data is discarded.
+   * the the rest of the line is discarded.  No token text is copied;
+   * the views of it are gathered in scratch (which is cleared first,
+   * and may be reused from one Production to the next so it needn't
+   * reallocate) and then copied contiguously into the arena.
+   *
+   * If the very first token has the form [w], where w is a
+   * non-negative number, then it isn't part of the production at
+   * all, but rather its relative weight:
+   *
+   *      [3] the <adjective> <noun> ;
+   *
+   * is three times as likely to be chosen as an unweighted
+   * production of the same Definition.
    */
   
-  Production(ifstream& infile);
+  Production(GrammarTokenizer& tokenizer, Arena& arena, vector<string_view>& scratch);
   
   /**
-   * vector<string>-backed Constructor: Production
-   * ---------------------------------------------
-   * Initializes a new Production to just encapsulate
-   * a copy of the provided vector.
+   * Array-backed Constructor: Production
+   * ------------------------------------
+   * Initializes a new Production to view the count
+   * string_views starting at words, which must
+   * outlive the Production.
    */
   
-  Production(const vector<string>& words) : phrases(words) {}
+  Production(const string_view *words, int count, double weight = 1) :
+    phrases(words), count(count), weight(weight) {}
+
+  /**
+   * Method: size
+   * ------------
+   * Returns the number of terminals and nonterminals.
+   */
+
+  int size() const { return count; }
+
+  /**
+   * Method: getWeight
+   * -----------------
+   * Returns the relative weight of the Production,
+   * which is 1 unless the grammar says otherwise.
+   */
+
+  double getWeight() const { return weight; }
   
   /**
    * Iterators: begin, end
    * ---------------------
    * Returns an iterator (fancy word for the generalization
    * of a pointer) to the first element or the past-the-end 
-   * element.  These iterators really are pointers to strings,
+   * element.  These iterators really are pointers to string_views,
    * so they respond properly to the notion of increment and
    * dereference.
    * 
@@ -83,16 +119,16 @@ class Production {
    * control idiom.
    *
    *    for (Production::iterator curr = prod.begin(); curr != prod.end(); ++curr) {
-   *        // manipulate curr (psuedo-pointer to C++ strings) or *curr (direct string objects).
+   *        // manipulate curr (psuedo-pointer to string_views) or *curr (direct string_view objects).
    */
   
-  iterator begin() { return phrases.begin(); }
-  const_iterator begin() const { return phrases.begin(); }
-  iterator end() { return phrases.end(); }
-  const_iterator end() const { return phrases.end(); }
+  const_iterator begin() const { return phrases; }
+  const_iterator end() const { return phrases + count; }
   
  private:
-  vector<string> phrases;
+  const string_view *phrases;
+  int count;
+  double weight;
 };
 
 #endif
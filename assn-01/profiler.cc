@@ -0,0 +1,221 @@
+/**
+ * File: profiler.cc
+ * -----------------
+ * Provides the implementation of the ExpansionProfile class.  Time is
+ * recorded in raw ticks of the time stamp counter, and only converted
+ * to seconds when it's reported, by comparing the ticks that have gone
+ * by since the profile was created with the time that's gone by, and
+ * scaling up for the sentences that weren't timed.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include "profiler.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * Returns the time stamp counter where there is one,
+ * and nanoseconds of the steady clock otherwise.
+ */
+
+static uint64_t readTicks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+ExpansionProfile::ExpansionProfile(const Grammar& grammar) :
+  grammar(grammar), totals(grammar.getNonterminalCount()),
+  sentences(0), timedSentences(0), timing(false),
+  createdTicks(readTicks()), created(chrono::steady_clock::now())
+{
+  node root = { -1, -1, -1, 0, 0 };
+  nodes.push_back(root);
+}
+
+/**
+ * Method: findChild
+ * -----------------
+ * Returns the node for the path that extends the parent's path
+ * with the specified nonterminal, creating it if there's room.
+ */
+
+int ExpansionProfile::findChild(int parent, int nonterminal)
+{
+  uint64_t key = (uint64_t) parent << 32 | (uint32_t) nonterminal;
+  unordered_map<uint64_t, int>::const_iterator found = children.find(key);
+  int child;
+  if (found != children.end()) {
+    child = found->second;
+  } else {
+    if (nodes.size() == kMaxNodes) return parent;
+    child = nodes.size();
+    node created = { nonterminal, parent, -1, 0, 0 };
+    nodes.push_back(created);
+    children[key] = child;
+  }
+
+  nodes[parent].lastChild = child;
+  return child;
+}
+
+/**
+ * Methods: enter, exit
+ * --------------------
+ * Self time and bytes are what's left of an expansion's
+ * totals once its children's totals are taken out.
+ */
+
+void ExpansionProfile::enter(int nonterminal, uint64_t position)
+{
+  int parent = 0;
+  if (!stack.empty()) {
+    parent = stack.back().node;
+  } else {
+    timing = sentences++ % kTimingPeriod == 0;
+    if (timing) timedSentences++;
+  }
+  int child = nodes[parent].lastChild;
+  if (child == -1 || nodes[child].nonterminal != nonterminal) child = findChild(parent, nonterminal);
+  nodes[child].expansions++;
+  nonterminalTotals& counts = totals[nonterminal];
+  counts.expansions++;
+  counts.active++;
+  activation pushed = { child, nonterminal, timing ? readTicks() : 0, position, 0, 0 };
+  stack.push_back(pushed);
+}
+
+void ExpansionProfile::exit(uint64_t position)
+{
+  activation& done = stack.back();
+  uint64_t ticks = timing ? readTicks() - done.startTicks : 0;
+  uint64_t bytes = position - done.startPosition;
+  nodes[done.node].selfTicks += ticks - done.childTicks;
+  nonterminalTotals& counts = totals[done.nonterminal];
+  counts.selfTicks += ticks - done.childTicks;
+  counts.selfBytes += bytes - done.childBytes;
+  if (--counts.active == 0) {
+    counts.totalTicks += ticks;
+    counts.totalBytes += bytes;
+  }
+  stack.pop_back();
+  if (stack.empty()) return;
+  stack.back().childTicks += ticks;
+  stack.back().childBytes += bytes;
+}
+
+void ExpansionProfile::abandon()
+{
+  for (size_t i = 0; i < stack.size(); i++)
+    totals[stack[i].nonterminal].active--;
+  stack.clear();
+}
+
+/**
+ * Method: merge
+ * -------------
+ * Every node is created after its parent, so the other profile's nodes
+ * can be matched up with (or added to) this one's in a single pass.
+ */
+
+void ExpansionProfile::merge(const ExpansionProfile& other)
+{
+  for (size_t i = 0; i < totals.size(); i++) {
+    totals[i].expansions += other.totals[i].expansions;
+    totals[i].selfBytes += other.totals[i].selfBytes;
+    totals[i].totalBytes += other.totals[i].totalBytes;
+    totals[i].selfTicks += other.totals[i].selfTicks;
+    totals[i].totalTicks += other.totals[i].totalTicks;
+  }
+
+  sentences += other.sentences;
+  timedSentences += other.timedSentences;
+
+  vector<int> matching(other.nodes.size(), 0);
+  for (size_t i = 1; i < other.nodes.size(); i++) {
+    const node& theirs = other.nodes[i];
+    matching[i] = findChild(matching[theirs.parent], theirs.nonterminal);
+    nodes[matching[i]].expansions += theirs.expansions;
+    nodes[matching[i]].selfTicks += theirs.selfTicks;
+  }
+}
+
+double ExpansionProfile::getSecondsPerTick() const
+{
+#if defined(__x86_64__) || defined(__i386__)
+  uint64_t ticks = readTicks() - createdTicks;
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - created).count();
+  return ticks == 0 ? 0 : seconds / ticks;
+#else
+  return 1e-9;
+#endif
+}
+
+double ExpansionProfile::getTimingScale() const
+{
+  return timedSentences == 0 ? 0 : (double) sentences / timedSentences;
+}
+
+string ExpansionProfile::getPath(int node) const
+{
+  if (nodes[node].parent <= 0) return string(grammar.getSymbolName(nodes[node].nonterminal));
+  return getPath(nodes[node].parent) + ";" + string(grammar.getSymbolName(nodes[node].nonterminal));
+}
+
+/**
+ * Method: printReport
+ * -------------------
+ * Sorted by total time, so the nonterminals at the top are
+ * the ones whose expansions are worth making cheaper.
+ */
+
+void ExpansionProfile::printReport(ostream& os) const
+{
+  vector<int> expanded;
+  size_t width = 12;
+  uint64_t allTicks = 0;
+  for (size_t i = 0; i < totals.size(); i++) {
+    if (totals[i].expansions == 0) continue;
+    expanded.push_back(i);
+    width = max(width, grammar.getSymbolName(i).size() + 2);
+    allTicks += totals[i].selfTicks;
+  }
+  sort(expanded.begin(), expanded.end(), [this](int a, int b) {
+    if (totals[a].totalTicks != totals[b].totalTicks) return totals[a].totalTicks > totals[b].totalTicks;
+    return totals[a].totalBytes > totals[b].totalBytes;
+  });
+
+  double milliseconds = 1000 * getSecondsPerTick() * getTimingScale();
+  os << left << setw(width) << "nonterminal" << right << setw(14) << "expansions"
+     << setw(14) << "self bytes" << setw(14) << "total bytes" << setw(12) << "self ms"
+     << setw(12) << "total ms" << setw(9) << "self %" << endl;
+  for (size_t i = 0; i < expanded.size(); i++) {
+    const nonterminalTotals& counts = totals[expanded[i]];
+    os << left << setw(width) << string(grammar.getSymbolName(expanded[i])) << right
+       << setw(14) << counts.expansions << setw(14) << counts.selfBytes << setw(14) << counts.totalBytes
+       << fixed << setprecision(3) << setw(12) << counts.selfTicks * milliseconds
+       << setw(12) << counts.totalTicks * milliseconds << setprecision(2)
+       << setw(9) << (allTicks == 0 ? 0.0 : 100.0 * counts.selfTicks / allTicks) << endl;
+  }
+  os << defaultfloat;
+}
+
+bool ExpansionProfile::writeFoldedStacks(const string& fileName) const
+{
+  ofstream out(fileName.c_str());
+  double nanoseconds = 1e9 * getSecondsPerTick() * getTimingScale();
+  for (size_t i = 1; i < nodes.size() && out; i++) {
+    uint64_t self = (uint64_t) (nodes[i].selfTicks * nanoseconds + 0.5);
+    if (self > 0) out << getPath(i) << ' ' << self << '\n';
+  }
+
+  out.close();
+  return !out.fail();
+}
@@ -0,0 +1,165 @@
+/**
+ * File: profiler.h
+ * ----------------
+ * Defines the ExpansionProfile class, which records where a
+ * SentenceGenerator spends its time: how often each nonterminal is
+ * expanded, how many bytes of output its expansions account for, and
+ * how long they take.  The same numbers are also kept for every distinct
+ * path of nested expansions from the start symbol down, so they can be
+ * written out as folded stacks (one "<a>;<b>;<c> <nanoseconds>" line per
+ * path) for flamegraph.pl and the tools compatible with it.
+ *
+ * Expansions and bytes are counted exactly, but only one sentence in
+ * every kTimingPeriod is timed, since reading the clock (even the time
+ * stamp counter) can cost as much as a small expansion; the times
+ * reported are scaled up accordingly.  What's left is a handful of
+ * increments and, usually, one comparison to find the path, so a
+ * profile is cheap enough to collect on every run.
+ */
+
+#ifndef __profiler__
+#define __profiler__
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include "grammar.h"
+using namespace std;
+
+class ExpansionProfile {
+
+ public:
+
+  /**
+   * Constructor: ExpansionProfile
+   * -----------------------------
+   * Constructs an empty profile of expansions of the nonterminals
+   * of the specified grammar, which must outlive the profile.
+   */
+
+  ExpansionProfile(const Grammar& grammar);
+
+  /**
+   * Methods: enter, exit
+   * --------------------
+   * Called by the generator as it starts and finishes expanding a
+   * nonterminal, with the output position (see OutputBuffer::getPosition)
+   * at that moment.  Every enter must be matched by an exit, or by
+   * abandon.
+   */
+
+  void enter(int nonterminal, uint64_t position);
+  void exit(uint64_t position);
+
+  /**
+   * Method: abandon
+   * ---------------
+   * Forgets the expansions still in progress, as when the generator
+   * gives up on a sentence.  They're still counted as expansions, but
+   * their time and bytes aren't recorded.
+   */
+
+  void abandon();
+
+  /**
+   * Method: merge
+   * -------------
+   * Adds everything recorded in another profile of the same grammar
+   * (typically collected by another thread) into this one.
+   */
+
+  void merge(const ExpansionProfile& other);
+
+  /**
+   * Method: printReport
+   * -------------------
+   * Prints one line per nonterminal that was ever expanded, most
+   * expensive first: the number of expansions, the bytes emitted by the
+   * nonterminal's own productions (self) and by its expansions in full
+   * (total), and the same split of the time spent.  A nonterminal that
+   * (directly or indirectly) expands itself has the inner expansions
+   * counted in its self numbers, but not twice in its totals.
+   */
+
+  void printReport(ostream& os) const;
+
+  /**
+   * Method: writeFoldedStacks
+   * -------------------------
+   * Writes one line per path of nested expansions, naming the
+   * nonterminals along the path separated by semicolons and followed
+   * by the self time spent at the end of that path, in nanoseconds.
+   *
+   * @return true if and only if the file was written successfully.
+   */
+
+  bool writeFoldedStacks(const string& fileName) const;
+
+ private:
+
+  /**
+   * The paths of nested expansions form a tree, with one node per path.
+   * When the tree grows too large (only a deeply recursive grammar can do
+   * that), longer paths are charged to the deepest node they already have.
+   */
+
+  static const size_t kMaxNodes = 1 << 20;
+
+  /**
+   * Sentences are timed at this interval (the first of them always is).
+   */
+
+  static const uint64_t kTimingPeriod = 16;
+
+  struct node {
+    int nonterminal;
+    int parent;
+    int lastChild;        // the child found most recently, which is usually the one wanted next
+    uint64_t expansions;
+    uint64_t selfTicks;
+  };
+
+  struct nonterminalTotals {
+    uint64_t expansions;
+    uint64_t selfBytes;
+    uint64_t totalBytes;
+    uint64_t selfTicks;
+    uint64_t totalTicks;
+    int active;           // expansions in progress, so totals only count the outermost one
+  };
+
+  struct activation {
+    int node;
+    int nonterminal;
+    uint64_t startTicks;
+    uint64_t startPosition;
+    uint64_t childTicks;
+    uint64_t childBytes;
+  };
+
+  const Grammar& grammar;
+  vector<nonterminalTotals> totals;
+  vector<node> nodes;                   // nodes[0] is the root, above every start symbol
+  unordered_map<uint64_t, int> children; // (parent << 32 | nonterminal) -> node
+  vector<activation> stack;
+  uint64_t sentences;
+  uint64_t timedSentences;
+  bool timing;                          // whether the current sentence is timed
+  uint64_t createdTicks;
+  chrono::steady_clock::time_point created;
+
+  int findChild(int parent, int nonterminal);
+  double getSecondsPerTick() const;
+  double getTimingScale() const;
+  string getPath(int node) const;
+
+  // marked as private so profiles aren't copied by accident
+  // (do NOT implement these).
+  ExpansionProfile(const ExpansionProfile& original);
+  ExpansionProfile& operator=(const ExpansionProfile& rhs);
+};
+
+#endif // ! __profiler__
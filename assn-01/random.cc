@@ -1,37 +1,79 @@
+
 #include <time.h>
-#include <stdlib.h>
-#include <limits.h>
-#include <cassert> // for assert macro
+#include <unistd.h>
 #include "random.h"
 
 /**
  * Constructor: RandomGenerator
  * ----------------------------
- * Initializes a RandomGenerator number generator, using 
+ * Initializes a RandomGenerator number generator, using
  * informtaion based on the current time as the seed.
  * This is the traditional way to set the stage for a computer
- * program to use random numbers.
+ * program to use random numbers.  The process id and the
+ * nanoseconds are folded in as well, so that generators created
+ * within the same second still differ.
  */
 
 RandomGenerator::RandomGenerator()
 {
-  srand(time(NULL));
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  setSeed(((uint64_t) now.tv_sec << 32) ^ (uint64_t) now.tv_nsec ^ ((uint64_t) getpid() << 48) ^
+          (uint64_t) (uintptr_t) this);
+}
+
+/**
+ * Method: setSeed
+ * ---------------
+ * splitmix64 is the seeding procedure recommended by the
+ * authors of xoshiro.  It never yields the all-zero state.
+ */
+
+void RandomGenerator::setSeed(uint64_t seed)
+{
+  for (int i = 0; i < 4; i++) {
+    uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    state[i] = z ^ (z >> 31);
+  }
 }
 
 /**
- * Method: getRandomInteger
- * ------------------------
- * Returns a seemingly random number between
- * the specified low and high, inclusive.  Based
- * on Eric Roberts' implementation from his
- * CS106A text.
+ * Method: setSeed
+ * ---------------
+ * The stream number goes through the splitmix64 finalizer, which
+ * is a bijection, so distinct streams of one seed never share a state.
  */
 
-int RandomGenerator::getRandomInteger(int low, int high)
+void RandomGenerator::setSeed(uint64_t seed, uint64_t stream)
 {
-  assert(low <= high);
-  double percent = (rand() / (static_cast<double>(RAND_MAX) + 1));
-  assert(percent >= 0.0 && percent < 1.0); 
-  int offset = static_cast<int>(percent * (high - low + 1));
-  return low + offset;
+  uint64_t z = stream + 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  setSeed(seed ^ z ^ (z >> 31));
+}
+
+/**
+ * Method: jump
+ * ------------
+ * Reference jump function for xoshiro256**; the
+ * constants encode the polynomial for 2^128 steps.
+ */
+
+void RandomGenerator::jump()
+{
+  static const uint64_t kJump[] = { 0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+                                    0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull };
+  uint64_t jumped[4] = { 0, 0, 0, 0 };
+  for (int i = 0; i < 4; i++) {
+    for (int bit = 0; bit < 64; bit++) {
+      if (kJump[i] & (1ull << bit)) {
+        for (int j = 0; j < 4; j++) jumped[j] ^= state[j];
+      }
+      getRandomBits();
+    }
+  }
+
+  for (int j = 0; j < 4; j++) state[j] = jumped[j];
 }
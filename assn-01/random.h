@@ -6,26 +6,103 @@
  * --------------
  * Provides a random number generator so
  * that pseudo-random numbers can be produced.
+ * The engine is xoshiro256** (Blackman and Vigna),
+ * whose entire state lives in the instance, so
+ * separate instances can be used by separate threads
+ * without any synchronization.
  */
 
+#include <stdint.h>
+#include <cassert> // for assert macro
+
 class RandomGenerator {
-  
- public: 
-  
+
+ public:
+
   /**
    * Constructor: RandomGenerator
    * ----------------------------
-   * Constructs a new RandomGenerator object.
+   * Constructs a new RandomGenerator object, seeded
+   * from the current time.
    */
-  
+
   RandomGenerator();
 
+  /**
+   * Constructor: RandomGenerator
+   * ----------------------------
+   * Constructs a new RandomGenerator object with the specified
+   * seed.  Two generators constructed with the same seed produce
+   * exactly the same sequence of numbers.
+   */
+
+  RandomGenerator(uint64_t seed) { setSeed(seed); }
+
+  /**
+   * Constructor: RandomGenerator
+   * ----------------------------
+   * Constructs a new RandomGenerator object for the specified
+   * stream of the specified seed (see setSeed below).
+   */
+
+  RandomGenerator(uint64_t seed, uint64_t stream) { setSeed(seed, stream); }
+
+  /**
+   * Method: setSeed
+   * ---------------
+   * Restarts the generator from the specified seed.  The
+   * 64-bit seed is expanded into the 256-bit state with
+   * splitmix64, so similar seeds still yield unrelated streams.
+   */
+
+  void setSeed(uint64_t seed);
+
+  /**
+   * Method: setSeed
+   * ---------------
+   * Restarts the generator from stream number stream of the specified
+   * seed.  The stream number is scrambled and folded into the seed, so
+   * every (seed, stream) pair yields an unrelated stream, and any one of
+   * them can be recreated on its own, in any order, on any thread.
+   * That's what lets sentence i of a run be generated from stream i.
+   */
+
+  void setSeed(uint64_t seed, uint64_t stream);
+
+  /**
+   * Method: jump
+   * ------------
+   * Advances the generator by 2^128 steps.  Calling jump k times
+   * on copies of one generator yields k streams that are
+   * guaranteed not to overlap, which is how concurrent
+   * generators should be set up.
+   */
+
+  void jump();
+
+  /**
+   * Method: getRandomBits
+   * ---------------------
+   * Returns the next 64 uniformly distributed bits.
+   */
+
+  uint64_t getRandomBits();
+
+  /**
+   * Method: getRandomFraction
+   * -------------------------
+   * Returns a real number drawn uniformly from [0, 1), with
+   * the full 53 bits of precision a double can hold.
+   */
+
+  double getRandomFraction() { return (getRandomBits() >> 11) * 0x1p-53; }
+
   /**
    * Method: getRandomInteger
    * ------------------------
    * Generates a seemingly random integer between the two specified
    * integers, inclusive.  All numbers in the range [low, high] are
-   * equally likely outcomes.  If low and high are the same, then 
+   * equally likely outcomes.  If low and high are the same, then
    * that number is guaranteed to be returned.  If low is greater than
    * high, then getRandomInteger asserts and ends the program.
    *
@@ -33,9 +110,57 @@ class RandomGenerator {
    * @param the highest number we'd like to be considered as a return value.
    * @return some number drawn uniformly from the range [low, high].
    */
-  
-  int getRandomInteger(int low, int high);  
+
+  int getRandomInteger(int low, int high);
+
+ private:
+  uint64_t state[4];
+
+  static uint64_t rotateLeft(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
 };
 
-#endif // ! __random__
+/**
+ * Both of the methods below are called once per expansion while
+ * generating sentences, so they're defined here where they can
+ * be inlined.
+ */
+
+inline uint64_t RandomGenerator::getRandomBits()
+{
+  uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+  uint64_t t = state[1] << 17;
+  state[2] ^= state[0];
+  state[3] ^= state[1];
+  state[1] ^= state[2];
+  state[0] ^= state[3];
+  state[2] ^= t;
+  state[3] = rotateLeft(state[3], 45);
+  return result;
+}
 
+/**
+ * Lemire's multiply-and-reject method: the high half of a 128-bit
+ * product maps the 64 random bits onto the range, and the rare
+ * draws that would make some outcomes more likely than others are
+ * rejected, so the result is exactly uniform and no division is
+ * needed in the common case.
+ */
+
+inline int RandomGenerator::getRandomInteger(int low, int high)
+{
+  assert(low <= high);
+  uint64_t range = (uint64_t) ((int64_t) high - low) + 1;
+  unsigned __int128 product = (unsigned __int128) getRandomBits() * range;
+  uint64_t leftover = (uint64_t) product;
+  if (leftover < range) {
+    uint64_t threshold = -range % range;
+    while (leftover < threshold) {
+      product = (unsigned __int128) getRandomBits() * range;
+      leftover = (uint64_t) product;
+    }
+  }
+
+  return (int) ((int64_t) low + (int64_t) (product >> 64));
+}
+
+#endif // ! __random__
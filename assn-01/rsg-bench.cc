@@ -0,0 +1,239 @@
+/**
+ * File: rsg-bench.cc
+ * ------------------
+ * Provides the implementation of the RSG benchmark harness.  Every
+ * grammar named on the command line is parsed and compiled several
+ * times, and then a fixed number of sentences is generated from it
+ * with a fixed seed, so two runs of the same build do exactly the
+ * same work.  The results are printed one JSON object per line, so
+ * they can be collected and compared from one build to the next.
+ *
+ * Sentences are generated into memory and thrown away, so the numbers
+ * measure parsing and generation alone, not the speed of the disk.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "grammar-file.h"
+#include "definition.h"
+#include "grammar.h"
+#include "generator.h"
+#include "output.h"
+#include "random.h"
+#include "tokenizer.h"
+using namespace std;
+
+/**
+ * Every call to the global operator new is counted, so the harness
+ * can report how many allocations parsing and generation make.  The
+ * harness is single-threaded, so a plain counter suffices.  Memory
+ * the OutputBuffer takes straight from malloc isn't counted, but it
+ * only reallocates while growing to fit the largest chunk.
+ */
+
+static unsigned long allocationCount = 0;
+
+void *operator new(size_t size)
+{
+  allocationCount++;
+  void *memory = malloc(size == 0 ? 1 : size);
+  if (memory == NULL) throw bad_alloc();
+  return memory;
+}
+
+void operator delete(void *memory) noexcept { free(memory); }
+void operator delete(void *memory, size_t) noexcept { free(memory); }
+
+/**
+ * Bundles everything the user can specify on the command line.
+ */
+
+struct benchOptions {
+  long count;      // sentences generated per grammar
+  long warmup;     // sentences generated before measuring starts
+  int repeat;      // times each grammar is parsed; the fastest counts
+  uint64_t seed;
+  int maxDepth;
+};
+
+static const long kDefaultCount = 20000;
+static const int kDefaultRepeat = 5;
+static const uint64_t kDefaultSeed = 107;
+
+/**
+ * Generated text is thrown away once this much has accumulated.
+ */
+
+static const size_t kDiscardSize = 1 << 20;
+
+static const char *const kStartSymbol = "<start>";
+
+typedef chrono::steady_clock benchClock;
+
+static double secondsSince(benchClock::time_point start)
+{
+  return chrono::duration<double>(benchClock::now() - start).count();
+}
+
+/**
+ * Returns the specified text as a quoted JSON string.
+ */
+
+static string quote(string_view text)
+{
+  string quoted = "\"";
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] == '"' || text[i] == '\\') quoted += '\\';
+    quoted += text[i];
+  }
+  return quoted + "\"";
+}
+
+/**
+ * Parses the command line, and returns false if it doesn't make
+ * sense.  Every argument that isn't a flag names a grammar file, and
+ * their indices are appended to fileArguments.
+ */
+
+static bool parseArguments(int argc, char *argv[], benchOptions& options, vector<int>& fileArguments)
+{
+  options.count = kDefaultCount;
+  options.warmup = 100;
+  options.repeat = kDefaultRepeat;
+  options.seed = kDefaultSeed;
+  options.maxDepth = SentenceGenerator::kDefaultMaxDepth;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--count" && i + 1 < argc) {
+      options.count = atol(argv[++i]);
+      if (options.count <= 0) return false;
+    } else if (arg == "--warmup" && i + 1 < argc) {
+      options.warmup = atol(argv[++i]);
+      if (options.warmup < 0) return false;
+    } else if (arg == "--repeat" && i + 1 < argc) {
+      options.repeat = atoi(argv[++i]);
+      if (options.repeat <= 0) return false;
+    } else if (arg == "--seed" && i + 1 < argc) {
+      options.seed = strtoull(argv[++i], NULL, 10);
+    } else if (arg == "--max-depth" && i + 1 < argc) {
+      options.maxDepth = atoi(argv[++i]);
+      if (options.maxDepth <= 0) return false;
+    } else if (arg.compare(0, 2, "--") == 0) {
+      return false;
+    } else {
+      fileArguments.push_back(i);
+    }
+  }
+
+  return !fileArguments.empty();
+}
+
+/**
+ * Benchmarks one grammar file and prints its line of results.
+ * Returns false (after printing a line with an "error" field)
+ * if the grammar couldn't be benchmarked at all.
+ */
+
+static bool benchmark(const char *fileName, const benchOptions& options)
+{
+  cout << "{\"grammar\":" << quote(fileName);
+  double parseSeconds = 0, compileSeconds = 0;
+  unsigned long parseAllocations = 0;
+  Grammar *grammar = NULL;
+  for (int i = 0; i < options.repeat; i++) {
+    delete grammar;
+    benchClock::time_point start = benchClock::now();
+    unsigned long allocationsBefore = allocationCount;
+    GrammarFile file(fileName);
+    if (!file.good()) {
+      cout << ",\"error\":\"Failed to open the file.\"}" << endl;
+      return false;
+    }
+    double parsed = secondsSince(start);
+    parseAllocations = allocationCount - allocationsBefore;
+    start = benchClock::now();
+    grammar = new Grammar(file.getDefinitions());
+    double compiled = secondsSince(start);
+    if (!grammar->good()) {
+      cout << ",\"error\":\"The grammar is too large to compile.\"}" << endl;
+      delete grammar;
+      return false;
+    }
+    if (i == 0 || parsed < parseSeconds) parseSeconds = parsed;
+    if (i == 0 || compiled < compileSeconds) compileSeconds = compiled;
+  }
+
+  cout << ",\"definitions\":" << grammar->getDefinitionCount()
+       << ",\"parseSeconds\":" << parseSeconds << ",\"parseAllocations\":" << parseAllocations
+       << ",\"compileSeconds\":" << compileSeconds
+       << ",\"tokenizer\":\"" << GrammarTokenizer::getInstructionSet() << "\"";
+  int start = grammar->lookup(kStartSymbol);
+  if (start == -1) {
+    cout << ",\"error\":\"The grammar doesn't define a <start> nonterminal.\"}" << endl;
+    delete grammar;
+    return false;
+  }
+
+  SentenceGenerator generator(*grammar, options.maxDepth);
+  RandomGenerator random(options.seed);
+  OutputBuffer out;
+  out.reserve(2 * kDiscardSize);
+  for (long i = 0; i < options.warmup; i++) {
+    generator.generate(start, random, out);
+    out.clear();
+  }
+
+  long failures = 0;
+  uint64_t bytes = 0;
+  unsigned long allocationsBefore = allocationCount;
+  benchClock::time_point begin = benchClock::now();
+  for (long i = 0; i < options.count; i++) {
+    if (!generator.generate(start, random, out)) failures++;
+    out.put('\n');
+    if (out.size() >= kDiscardSize) {
+      bytes += out.size();
+      out.clear();
+    }
+  }
+  double seconds = secondsSince(begin);
+  bytes += out.size();
+  unsigned long allocations = allocationCount - allocationsBefore;
+
+  cout << ",\"sentences\":" << options.count << ",\"failures\":" << failures
+       << ",\"bytes\":" << bytes << ",\"seconds\":" << seconds
+       << ",\"sentencesPerSecond\":" << options.count / seconds
+       << ",\"bytesPerSecond\":" << bytes / seconds
+       << ",\"allocationsPerSentence\":" << (double) allocations / options.count << "}" << endl;
+  delete grammar;
+  return true;
+}
+
+/**
+ * Benchmarks every grammar named on the command line, in order.
+ * The exit code is nonzero if any of them couldn't be benchmarked.
+ */
+
+int main(int argc, char *argv[])
+{
+  benchOptions options;
+  vector<int> fileArguments;
+  if (!parseArguments(argc, argv, options, fileArguments)) {
+    cerr << "Usage: rsg-bench [--count <n>] [--warmup <n>] [--repeat <n>] [--seed <n>] [--max-depth <n>]" << endl;
+    cerr << "                 <path to grammar text file> ..." << endl;
+    return 1;
+  }
+
+  cout << "{\"seed\":" << options.seed << ",\"count\":" << options.count
+       << ",\"warmup\":" << options.warmup << ",\"repeat\":" << options.repeat
+       << ",\"maxDepth\":" << options.maxDepth << "}" << endl;
+  bool succeeded = true;
+  for (size_t i = 0; i < fileArguments.size(); i++)
+    if (!benchmark(argv[fileArguments[i]], options)) succeeded = false;
+  return succeeded ? 0 : 2;
+}
@@ -2,107 +2,476 @@
  * File: rsg.cc
  * ------------
  * Provides the implementation of the full RSG application, which
- * relies on the services of the built-in string, ifstream, vector,
+ * relies on the services of the built-in string, string_view, vector,
  * and map classes as well as the custom Production and Definition
  * classes provided with the assignment.
  */
  
 #include <map>
+#include <memory>
+#include <cmath>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <vector>
-#include <fstream>
+#include <iostream>
+#include <string_view>
+#include "grammar-file.h"
 #include "definition.h"
 #include "production.h"
+#include "grammar.h"
+#include "generator.h"
+#include "output.h"
+#include "profiler.h"
+#include "uniform.h"
+#include "enumerator.h"
+#include "server.h"
+#include "bulk.h"
+#include "analysis.h"
+#include "random.h"
 using namespace std;
 
 /**
- * Takes a reference to a legitimate infile (one that's been set up
- * to layer over a file) and populates the grammar map with the
- * collection of definitions that are spelled out in the referenced
- * file.  The function is written under the assumption that the
- * referenced data file is really a grammar file that's properly
- * formatted.  You may assume that all grammars are in fact properly
- * formatted.
- *
- * @param infile a valid reference to a flat text file storing the grammar.
- * @param grammar a reference to the STL map, which maps nonterminal strings
- *                to their definitions.
+ * Every sentence is an expansion of this nonterminal.
+ */
+
+static const char *const kStartSymbol = "<start>";
+
+/**
+ * Bundles everything the user can specify on the command line.
  */
 
-static void readGrammar(ifstream& infile, map<string, Definition>& grammar)
+struct rsgOptions {
+  const char *grammarFileName;
+  int maxDepth;
+  long count;                 // 0 unless bulk generation was requested
+  uint64_t offset;            // the index of the first sentence generated in bulk
+  bool distinct;              // count only distinct sentences, and write no repeats
+  int threads;
+  uint64_t seed;
+  const char *outputFileName; // NULL means standard output
+  const char *compiledFileName; // non-NULL only for --compile
+  bool check;                 // print the static analysis and stop
+  int uniformTokens;          // 0 unless derivations are to be sampled uniformly
+  bool enumerate;             // list every derivation instead of sampling
+  int maxTokens;              // bounds the sentences listed by --enumerate
+  long limit;                 // the most sentences --enumerate lists, or 0 for no limit
+  const char *checkpoint;     // where --enumerate resumes, or NULL
+  bool serve;                 // answer requests on standard input
+  const char *socketPath;     // answer requests on this Unix socket, or NULL
+  bool profile;               // print a profile of the expansions to standard error
+  const char *foldedFileName; // write the profile as folded stacks to this file, or NULL
+};
+
+/**
+ * Parses the command line into the specified rsgOptions, and
+ * returns false if the arguments don't make sense.  Flags may
+ * appear anywhere, and the one argument that isn't a flag is
+ * taken to be the name of the grammar file.  --compile expects
+ * a second such argument naming the compiled file to be written.
+ * Only sentences generated by choosing productions can be profiled.
+ */
+
+static bool parseArguments(int argc, char *argv[], rsgOptions& options)
 {
-  while (true) {
-    string uselessText;
-    getline(infile, uselessText, '{');
-    if (infile.eof()) return;  // true? we encountered EOF before we saw a '{': no more productions!
-    infile.putback('{');
-    Definition def(infile);
-    grammar[def.getNonterminal()] = def;
+  options.grammarFileName = NULL;
+  options.maxDepth = SentenceGenerator::kDefaultMaxDepth;
+  options.count = 0;
+  options.offset = 0;
+  options.distinct = false;
+  options.threads = thread::hardware_concurrency();
+  if (options.threads == 0) options.threads = 1;
+  options.seed = time(NULL);
+  options.outputFileName = NULL;
+  options.compiledFileName = NULL;
+  options.check = false;
+  options.uniformTokens = 0;
+  options.enumerate = false;
+  options.maxTokens = INT_MAX;
+  options.limit = 0;
+  options.checkpoint = NULL;
+  options.serve = false;
+  options.socketPath = NULL;
+  options.profile = false;
+  options.foldedFileName = NULL;
+  bool compile = false;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--max-depth" && i + 1 < argc) {
+      options.maxDepth = atoi(argv[++i]);
+      if (options.maxDepth <= 0) return false;
+    } else if (arg == "--count" && i + 1 < argc) {
+      options.count = atol(argv[++i]);
+      if (options.count <= 0) return false;
+    } else if (arg == "--distinct" && i + 1 < argc) {
+      options.count = atol(argv[++i]);
+      options.distinct = true;
+      if (options.count <= 0) return false;
+    } else if (arg == "--offset" && i + 1 < argc) {
+      options.offset = strtoull(argv[++i], NULL, 10);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      options.threads = atoi(argv[++i]);
+      if (options.threads <= 0) return false;
+    } else if (arg == "--seed" && i + 1 < argc) {
+      options.seed = strtoull(argv[++i], NULL, 10);
+    } else if (arg == "--output" && i + 1 < argc) {
+      options.outputFileName = argv[++i];
+    } else if (arg == "--uniform" && i + 1 < argc) {
+      options.uniformTokens = atoi(argv[++i]);
+      if (options.uniformTokens <= 0) return false;
+    } else if (arg == "--enumerate") {
+      options.enumerate = true;
+    } else if (arg == "--max-tokens" && i + 1 < argc) {
+      options.maxTokens = atoi(argv[++i]);
+      if (options.maxTokens < 0) return false;
+    } else if (arg == "--limit" && i + 1 < argc) {
+      options.limit = atol(argv[++i]);
+      if (options.limit <= 0) return false;
+    } else if (arg == "--resume" && i + 1 < argc) {
+      options.checkpoint = argv[++i];
+    } else if (arg == "--serve") {
+      options.serve = true;
+    } else if (arg == "--socket" && i + 1 < argc) {
+      options.socketPath = argv[++i];
+    } else if (arg == "--profile") {
+      options.profile = true;
+    } else if (arg == "--profile-folded" && i + 1 < argc) {
+      options.foldedFileName = argv[++i];
+    } else if (arg == "--compile") {
+      compile = true;
+    } else if (arg == "--check") {
+      options.check = true;
+    } else if (arg.compare(0, 2, "--") == 0 || options.compiledFileName != NULL) {
+      return false;
+    } else if (options.grammarFileName != NULL) {
+      options.compiledFileName = argv[i];
+    } else {
+      options.grammarFileName = argv[i];
+    }
   }
+
+  bool profiling = options.profile || options.foldedFileName != NULL;
+  if (profiling && (options.uniformTokens > 0 || options.enumerate || options.serve || options.socketPath != NULL))
+    return false;
+  return options.grammarFileName != NULL && compile == (options.compiledFileName != NULL);
 }
 
-/* Recursive method which takes two arguments and generates random sentence */
-string generateRandomSentence(map<string, Definition>& grammar, string expand){
-  string result = "";
-  Production prod = grammar[expand].getRandomProduction();
-
-  for (Production::iterator curr = prod.begin(); curr != prod.end(); ++curr) {
-    string s = *curr;
-    if(s[0] == '<' && s[s.length() - 1] == '>'){
-      string addition = generateRandomSentence(grammar, s);
-      result += addition;
-    }else{
-      result += s;
+/**
+ * Loads the grammar named in the options, which may either be a text
+ * grammar or a file written by rsg --compile, and returns its compiled
+ * form.  A compiled file is mapped and used in place, so there's no
+ * parsing at all.  A text grammar is analyzed before it's compiled, and
+ * rejected if generation from it is bound to fail (compiled files were
+ * analyzed when they were compiled, and can't be checked).  NULL is returned (after an error
+ * message has been printed) if the grammar couldn't be loaded, and
+ * status is set to the exit code main should return.
+ *
+ * @param options the parsed command line.
+ * @param expectedBytes set to the expected length of a sentence, or 0
+ *                      if that isn't known.
+ * @param status set to the exit code if NULL is returned.
+ */
+
+static Grammar *loadGrammar(const rsgOptions& options, double& expectedBytes, int& status)
+{
+  const char *fileName = options.grammarFileName;
+  expectedBytes = 0;
+  status = 2;
+  if (Grammar::isCompiledFile(fileName)) {
+    if (options.check) {
+      cerr << "The file named \"" << fileName << "\" is a compiled grammar, which can't be checked.  "
+           << "Run --check on the grammar text file it was compiled from." << endl;
+      status = 1;
+      return NULL;
     }
-    if(curr != prod.end()){
-      result += " ";
+    Grammar *grammar = new Grammar(string(fileName));
+    if (grammar->good()) return grammar;
+    delete grammar;
+    cerr << "The file named \"" << fileName << "\" is not a valid compiled grammar.  Try recompiling it." << endl;
+    return NULL;
+  }
+
+  GrammarFile grammarFile(fileName);
+  if (!grammarFile.good()) {
+    cerr << "Failed to open the file named \"" << fileName << "\".  Check to ensure the file exists. " << endl;
+    return NULL;
+  }
+
+  const map<string_view, Definition>& definitions = grammarFile.getDefinitions();
+  GrammarAnalysis analysis(definitions, kStartSymbol, options.maxDepth, options.check);
+  if (options.check) {
+    analysis.printReport(cout);
+    status = analysis.isUsable() ? 0 : 5;
+    return NULL;
+  }
+  if (!analysis.isUsable()) {
+    analysis.printErrors(cerr);
+    status = 5;
+    return NULL;
+  }
+
+  if (isfinite(analysis.getStartReport()->expectedBytes)) expectedBytes = analysis.getStartReport()->expectedBytes;
+  Grammar *grammar = new Grammar(definitions);
+  if (grammar->good()) return grammar;
+  delete grammar;
+  cerr << "The grammar in \"" << fileName << "\" is too large to compile (the limit is 4 GiB)." << endl;
+  status = 5;
+  return NULL;
+}
+
+/**
+ * Returns a file descriptor for standard output, or for the requested
+ * output file, or -1 (after printing an error message) if the output
+ * file couldn't be opened.
+ */
+
+static int openOutput(const rsgOptions& options)
+{
+  if (options.outputFileName == NULL) return STDOUT_FILENO;
+  int fd = open(options.outputFileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) cerr << "Failed to open the output file named \"" << options.outputFileName << "\"." << endl;
+  return fd;
+}
+
+/**
+ * Generates options.count sentences across options.threads threads
+ * and sends them, one per line, to standard output or to the
+ * requested output file.  Sentence i depends only on the seed and
+ * options.offset + i, so --offset regenerates any part of a run.
+ * With --distinct, options.count distinct sentences are written
+ * instead, each the first of its kind, in the order generated.
+ * Sentences that keep failing are left out, with a note to that
+ * effect, rather than ending the run.
+ */
+
+static int generateInBulk(const Grammar& grammar, int start, const rsgOptions& options, double expectedBytes,
+                          const ExpansionCounts *uniform, ExpansionProfile *profile)
+{
+  int fd = openOutput(options);
+  if (fd == -1) return 2;
+
+  bulkOptions bulk;
+  bulk.count = options.count;
+  bulk.distinct = options.distinct;
+  bulk.offset = options.offset;
+  bulk.threads = options.threads;
+  bulk.seed = options.seed;
+  bulk.maxDepth = options.maxDepth;
+  bulk.sentenceBytesHint = uniform != NULL ? 0 : expectedBytes;
+  bulk.uniform = uniform;
+  bulk.profile = profile;
+  long skipped;
+  string errorMessage;
+  bool succeeded = generateBulk(grammar, start, bulk, fd, skipped, errorMessage);
+  if (fd != STDOUT_FILENO) close(fd);
+  if (!succeeded) {
+    cerr << errorMessage << endl;
+    return 4;
+  }
+  if (skipped > 0)
+    cerr << "Left out " << skipped << (skipped == 1 ? " sentence" : " sentences")
+         << " that couldn't be generated.  " << errorMessage << endl;
+
+  return 0;
+}
+
+/**
+ * Prints the profile to standard error and writes it as folded stacks,
+ * as the options request, once generation is over (whether or not it
+ * succeeded).  Returns the exit status generation ended with, unless
+ * that was 0 and the folded stacks couldn't be written.
+ */
+
+static int reportProfile(const ExpansionProfile *profile, const rsgOptions& options, int status)
+{
+  if (profile == NULL) return status;
+  if (options.profile) profile->printReport(cerr);
+  if (options.foldedFileName != NULL && !profile->writeFoldedStacks(options.foldedFileName)) {
+    cerr << "Failed to write the folded stacks to \"" << options.foldedFileName << "\"." << endl;
+    if (status == 0) status = 2;
+  }
+  return status;
+}
+
+/**
+ * Lists the derivations of the start symbol within the depth and token
+ * bounds, one sentence per line, starting just after the checkpoint if
+ * one was given.  Enumeration works from the text of the grammar, so
+ * a compiled grammar can't be enumerated.  If the limit cuts the listing
+ * short, the checkpoint to resume from is printed to standard error.
+ */
+
+static int enumerateSentences(const rsgOptions& options)
+{
+  if (Grammar::isCompiledFile(options.grammarFileName)) {
+    cerr << "Only text grammars can be enumerated." << endl;
+    return 2;
+  }
+
+  GrammarFile grammarFile(options.grammarFileName);
+  if (!grammarFile.good()) {
+    cerr << "Failed to open the file named \"" << options.grammarFileName << "\".  Check to ensure the file exists. " << endl;
+    return 2;
+  }
+  if (grammarFile.getDefinitions().count(kStartSymbol) == 0) {
+    cerr << "The grammar doesn't define a <start> nonterminal." << endl;
+    return 3;
+  }
+
+  DerivationEnumerator enumerator(grammarFile.getDefinitions(), kStartSymbol, options.maxDepth, options.maxTokens);
+  if (options.checkpoint != NULL && !enumerator.resume(options.checkpoint)) {
+    cerr << "\"" << options.checkpoint << "\" isn't a checkpoint of this grammar within these bounds." << endl;
+    return 1;
+  }
+
+  int fd = openOutput(options);
+  if (fd == -1) return 2;
+  long listed = 0;
+  bool succeeded;
+  {
+    OutputBuffer out(fd);
+    while ((options.limit == 0 || listed < options.limit) && enumerator.next(out)) {
+      out.put('\n');
+      listed++;
     }
+    succeeded = out.flush();
+    if (!succeeded) cerr << "Failed to write sentences: " << strerror(out.getErrorNumber()) << endl;
+  }
+  if (fd != STDOUT_FILENO) close(fd);
+  if (!succeeded) return 4;
+
+  if (options.limit > 0 && listed == options.limit) cerr << "Resume with --resume " << enumerator.getCheckpoint() << endl;
+  return 0;
+}
+
+/**
+ * Keeps the grammar resident and generates batches of sentences on
+ * request (see server.h), over the Unix socket if one was named, and
+ * over standard input and output otherwise.  Whenever the grammar file
+ * changes, it's reloaded just as it was loaded the first time.
+ */
+
+static int serveGrammar(Grammar *grammar, const rsgOptions& options)
+{
+  GrammarServer::grammarLoader load = [&options]() {
+    double expectedBytes;
+    int status;
+    return loadGrammar(options, expectedBytes, status);
+  };
+  GrammarServer server(options.grammarFileName, grammar, load, options.maxDepth);
+  if (options.socketPath == NULL) {
+    server.serve(STDIN_FILENO, STDOUT_FILENO);
+    return 0;
   }
 
-  return result;
+  string errorMessage;
+  server.listen(options.socketPath, errorMessage);
+  cerr << errorMessage << endl;
+  return 2;
 }
 
 /**
  * Performs the rudimentary error checking needed to confirm that
  * the client provided a grammar file.  It then continues to
- * open the file, read the grammar into a map<string, Definition>,
- * and then print out the total number of Definitions that were read
- * in.  You're to update and decompose the main function to print
- * three randomly generated sentences, as illustrated by the sample
- * application.
+ * load and compile the grammar, and then print out the total number
+ * of Definitions that were read in, followed by three randomly
+ * generated sentences.  If a sentence count was specified, then
+ * the banner is suppressed and that many sentences are generated
+ * in bulk instead (or, with --distinct, that many distinct ones).
+ * With --compile, the compiled grammar is written to disk and
+ * nothing is generated, and with --check, the grammar's
+ * static analysis is printed and nothing is generated.  With
+ * --uniform, every derivation of up to the specified number of
+ * terminals is equally likely, rather than every production, and
+ * with --enumerate, every derivation within the bounds is listed.
+ * --serve and --socket keep the grammar loaded and answer requests.
+ * --profile and --profile-folded report where generation spent its time.
  *
  * @param argc the number of tokens making up the command that invoked
- *             the RSG executable.  There must be at least two arguments,
- *             and only the first two are used.
+ *             the RSG executable.  There must be at least two arguments.
  * @param argv the sequence of tokens making up the command, where each
  *             token is represented as a '\0'-terminated C string.
  */
 
 int main(int argc, char *argv[])
 {
-  if (argc == 1) {
+  rsgOptions options;
+  if (!parseArguments(argc, argv, options)) {
     cerr << "You need to specify the name of a grammar file." << endl;
-    cerr << "Usage: rsg <path to grammar text file>" << endl;
+    cerr << "Usage: rsg [--max-depth <n>] [--uniform <max tokens> | --profile | --profile-folded <file>]" << endl;
+    cerr << "           [(--count | --distinct) <n> [--offset <n>] [--threads <n>] [--seed <n>] [--output <file>]]" << endl;
+    cerr << "           <path to grammar text or compiled file>" << endl;
+    cerr << "       rsg --compile <path to grammar text file> <path to compiled file>" << endl;
+    cerr << "       rsg --check [--max-depth <n>] <path to grammar text file>" << endl;
+    cerr << "       rsg --enumerate [--max-depth <n>] [--max-tokens <n>] [--limit <n>] [--resume <checkpoint>]" << endl;
+    cerr << "           [--output <file>] <path to grammar text file>" << endl;
+    cerr << "       rsg (--serve | --socket <path>) [--max-depth <n>] <path to grammar text or compiled file>" << endl;
     return 1; // non-zero return value means something bad happened 
   }
   
-  ifstream grammarFile(argv[1]);
-  if (grammarFile.fail()) {
-    cerr << "Failed to open the file named \"" << argv[1] << "\".  Check to ensure the file exists. " << endl;
-    return 2; // each bad thing has its own bad return value
-  }
+  if (options.enumerate) return enumerateSentences(options);
+
+  double expectedBytes;
+  int status;
+  unique_ptr<Grammar> grammar(loadGrammar(options, expectedBytes, status));
+  if (grammar == NULL) return status; // each bad thing has its own bad return value
 
   // things are looking good...
-  map<string, Definition> grammar;
-  readGrammar(grammarFile, grammar);
-  cout << "The grammar file called \"" << argv[1] << "\" contains "
-       << grammar.size() << " definitions." << endl;
+  const Grammar& compiled = *grammar;
+  if (options.compiledFileName != NULL) {
+    if (compiled.save(options.compiledFileName)) return 0;
+    cerr << "Failed to write the compiled grammar to \"" << options.compiledFileName << "\"." << endl;
+    return 2;
+  }
+
+  int start = compiled.lookup(kStartSymbol);
+  if (start == -1) {
+    cerr << "The grammar doesn't define a <start> nonterminal." << endl;
+    return 3;
+  }
+
+  if (options.serve || options.socketPath != NULL) return serveGrammar(grammar.release(), options);
+
+  unique_ptr<ExpansionCounts> counts;
+  if (options.uniformTokens > 0) {
+    counts.reset(new ExpansionCounts(compiled, start, options.uniformTokens));
+    if (!counts->good()) {
+      cerr << counts->getErrorMessage() << endl;
+      return 5;
+    }
+  }
+
+  unique_ptr<ExpansionProfile> profile;
+  if (options.profile || options.foldedFileName != NULL) profile.reset(new ExpansionProfile(compiled));
+  if (options.count > 0)
+    return reportProfile(profile.get(), options,
+                         generateInBulk(compiled, start, options, expectedBytes, counts.get(), profile.get()));
+  cout << "The grammar file called \"" << options.grammarFileName << "\" contains "
+       << compiled.getDefinitionCount() << " definitions." << endl;
 
   /* Prints out 3 versions of random sentences */
+  SentenceGenerator generator(compiled, options.maxDepth);
+  generator.setProfile(profile.get());
+  unique_ptr<UniformGenerator> uniform;
+  if (counts != NULL) uniform.reset(new UniformGenerator(*counts));
+  RandomGenerator random;
+  OutputBuffer out(STDOUT_FILENO); // cout was flushed by endl, so nothing gets reordered
   for(int i = 0; i < 3; i++){
-    string start = "<start>";
-    string s = generateRandomSentence(grammar, start);
-    cout << "Version #" << i + 1 << ": " << endl;
-    cout << s << endl;
+    uint64_t versionStart = out.getPosition();
+    out.append("Version #" + to_string(i + 1) + ": \n");
+    bool generated = uniform != NULL ? uniform->generate(random, out) : generator.generate(start, random, out);
+    if (!generated) {
+      out.rewind(versionStart);
+      out.flush();
+      cerr << (uniform != NULL ? uniform->getErrorMessage() : generator.getErrorMessage()) << endl;
+      return reportProfile(profile.get(), options, 4);
+    }
+    out.put('\n');
   }
-  return 0;
+  out.flush();
+  return reportProfile(profile.get(), options, 0);
 }
@@ -0,0 +1,255 @@
+/**
+ * File: server.cc
+ * ---------------
+ * Provides the implementation of the GrammarServer class.  The grammar
+ * being served lives behind a shared_ptr that's read and replaced
+ * atomically.  Each request takes its own reference to whatever grammar
+ * is current when it arrives, so a reload never waits for requests in
+ * progress, and the old grammar is released when the last of them ends.
+ */
+
+#include <chrono>
+#include <errno.h>
+#include <iostream>
+#include <signal.h>
+#include <sstream>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "server.h"
+
+/**
+ * How often the watcher looks at the grammar file.
+ */
+
+static const chrono::milliseconds kPollInterval(250);
+
+/**
+ * The most sentences a single request may ask for.  Each batch is
+ * assembled in memory before any of it is sent, so that a failure
+ * can still be reported cleanly.
+ */
+
+static const long kMaxBatch = 1000000;
+
+/**
+ * Class: lineReader
+ * -----------------
+ * Reads lines from a file descriptor through a buffer
+ * of its own, so lines needn't be read a byte at a time.
+ */
+
+class lineReader {
+ public:
+  lineReader(int fd) : fd(fd), next(0), end(0) {}
+
+  /**
+   * Sets line to the next line, without its '\n' (or "\r\n"), and
+   * returns true, or returns false once the input is exhausted.
+   */
+
+  bool readLine(string& line)
+  {
+    line.clear();
+    while (true) {
+      if (next == end) {
+        ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return !line.empty();
+        next = 0;
+        end = count;
+      }
+      char *found = (char *) memchr(buffer + next, '\n', end - next);
+      size_t stop = found == NULL ? end : found - buffer;
+      line.append(buffer + next, stop - next);
+      next = found == NULL ? end : stop + 1;
+      if (found == NULL) continue;
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      return true;
+    }
+  }
+
+ private:
+  int fd;
+  char buffer[64 << 10];
+  size_t next, end;
+};
+
+/**
+ * Returns true if and only if the two stat results describe
+ * the same version of the same file.
+ */
+
+static bool isSameVersion(const struct stat& a, const struct stat& b)
+{
+  return a.st_ino == b.st_ino && a.st_size == b.st_size &&
+    a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+}
+
+GrammarServer::GrammarServer(const string& fileName, Grammar *initial, grammarLoader load, int maxDepth) :
+  fileName(fileName), load(load), maxDepth(maxDepth), stopping(false)
+{
+  atomic_store(&current, shared_ptr<const Grammar>(initial));
+  watcher = thread(&GrammarServer::watch, this);
+}
+
+GrammarServer::~GrammarServer()
+{
+  {
+    lock_guard<mutex> guard(stopLock);
+    stopping = true;
+  }
+  stopRequested.notify_all();
+  watcher.join();
+}
+
+/**
+ * Method: watch
+ * -------------
+ * The watcher thread.  It remembers the version of the file last loaded,
+ * and the version it saw on the previous poll; a version different from
+ * the loaded one is loaded once two polls in a row agree on it.
+ */
+
+void GrammarServer::watch()
+{
+  struct stat loaded, previous, latest;
+  memset(&loaded, 0, sizeof(loaded));
+  stat(fileName.c_str(), &loaded);
+  previous = loaded;
+
+  unique_lock<mutex> guard(stopLock);
+  while (!stopRequested.wait_for(guard, kPollInterval, [this] { return stopping; })) {
+    if (stat(fileName.c_str(), &latest) != 0) continue; // mid-replacement, perhaps
+    bool settled = isSameVersion(latest, previous);
+    previous = latest;
+    if (!settled || isSameVersion(latest, loaded)) continue;
+
+    loaded = latest;
+    guard.unlock();
+    Grammar *grammar = load();
+    if (grammar != NULL) {
+      atomic_store(&current, shared_ptr<const Grammar>(grammar));
+      cerr << "Reloaded the grammar from \"" << fileName << "\"." << endl;
+    } else {
+      cerr << "Still serving the previous version of \"" << fileName << "\"." << endl;
+    }
+    guard.lock();
+  }
+}
+
+/**
+ * Method: respond
+ * ---------------
+ * Parses one request and writes its response to out, returning false
+ * if the conversation should end.  The batch is generated into the
+ * conversation's reusable batch buffer first, so a failure partway
+ * through can still be reported as an error rather than a short batch.
+ * The conversation's generator is rebuilt only if the grammar was
+ * reloaded since its last request.
+ */
+
+bool GrammarServer::respond(const string& request, conversation& state, OutputBuffer& out) const
+{
+  istringstream tokens(request);
+  string first, symbol, extra;
+  long count;
+  uint64_t seed;
+  if (!(tokens >> first)) return true; // blank lines are ignored
+  if (first == "quit") return false;
+
+  istringstream countToken(first);
+  if (!(countToken >> count) || !countToken.eof() || !(tokens >> seed) || (tokens >> symbol && tokens >> extra)) {
+    out.append("ERROR Requests have the form <count> <seed> [<start nonterminal>].\n");
+    return true;
+  }
+  if (count < 0 || count > kMaxBatch) {
+    out.append("ERROR The count must be between 0 and " + to_string(kMaxBatch) + ".\n");
+    return true;
+  }
+
+  shared_ptr<const Grammar> grammar = atomic_load(&current);
+  if (grammar != state.grammar) {
+    state.generator.reset(new SentenceGenerator(*grammar, maxDepth));
+    state.grammar = grammar;
+  }
+  vector<batchJob> jobs(1);
+  jobs[0].start = symbol.empty() ? string_view("<start>") : string_view(symbol);
+  jobs[0].count = count;
+  jobs[0].seed = seed;
+  state.batch.clear();
+  string errorMessage;
+  if (!generateBatch(*state.generator, jobs, state.batch, NULL, errorMessage)) {
+    out.append("ERROR " + errorMessage + "\n");
+    return true;
+  }
+
+  out.append("OK " + to_string(count) + "\n");
+  out.append(state.batch.data(), state.batch.size());
+  return true;
+}
+
+void GrammarServer::serve(int in, int out)
+{
+  lineReader reader(in);
+  conversation state;
+  OutputBuffer responses(out);
+  string request;
+  while (reader.readLine(request)) {
+    if (!respond(request, state, responses)) break;
+    if (!responses.flush()) break; // the client went away
+  }
+}
+
+/**
+ * Method: listen
+ * --------------
+ * SIGPIPE is ignored, so a client that disconnects early makes a
+ * write fail (and its conversation end) rather than killing the server.
+ */
+
+bool GrammarServer::listen(const string& socketPath, string& errorMessage)
+{
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socketPath.size() >= sizeof(address.sun_path)) {
+    errorMessage = "The socket path \"" + socketPath + "\" is too long.";
+    return false;
+  }
+  strcpy(address.sun_path, socketPath.c_str());
+
+  struct stat existing;
+  if (lstat(socketPath.c_str(), &existing) == 0) {
+    if (!S_ISSOCK(existing.st_mode)) {
+      errorMessage = "Something other than a socket is already at \"" + socketPath + "\".";
+      return false;
+    }
+    if (unlink(socketPath.c_str()) != 0 && errno != ENOENT) {
+      errorMessage = "Failed to remove the old socket at \"" + socketPath + "\": " + strerror(errno);
+      return false;
+    }
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener == -1 || bind(listener, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+      ::listen(listener, SOMAXCONN) != 0) {
+    errorMessage = "Failed to listen on \"" + socketPath + "\": " + strerror(errno);
+    if (listener != -1) close(listener);
+    return false;
+  }
+
+  while (true) {
+    int connection = accept(listener, NULL, NULL);
+    if (connection == -1) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      errorMessage = string("Failed to accept a connection: ") + strerror(errno);
+      close(listener);
+      return false;
+    }
+    thread([this, connection] { serve(connection, connection); close(connection); }).detach();
+  }
+}
@@ -0,0 +1,133 @@
+/**
+ * File: server.h
+ * --------------
+ * Defines the GrammarServer class, which keeps a compiled grammar
+ * resident and generates batches of sentences on request, either over
+ * a pair of file descriptors (standard input and output, say) or over
+ * connections to a Unix domain socket.  The protocol is line-based:
+ *
+ *     request:   <count> <seed> [<start nonterminal>]
+ *     response:  OK <count>, followed by count lines, one per sentence
+ *          or:   ERROR <explanation>
+ *
+ * A request for "quit" ends the conversation.  The same seed always
+ * produces the same batch from the same grammar.  Meanwhile, the
+ * grammar file is watched, and when it changes, a freshly loaded
+ * grammar is swapped in for all requests that arrive afterwards, while
+ * requests already in progress finish with the grammar they started with.
+ */
+
+#ifndef __server__
+#define __server__
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "batch.h"
+#include "generator.h"
+#include "grammar.h"
+#include "output.h"
+using namespace std;
+
+class GrammarServer {
+
+ public:
+
+  /**
+   * Type: grammarLoader
+   * -------------------
+   * Loads the grammar file afresh, returning NULL (after reporting
+   * why) if it can't be loaded.  It's called from the watcher thread.
+   */
+
+  typedef function<Grammar *()> grammarLoader;
+
+  /**
+   * Constructor: GrammarServer
+   * --------------------------
+   * Starts serving the specified grammar, and starts a thread that
+   * watches the named file and reloads it (using the loader) whenever
+   * it changes.  A change is acted upon only once the file has stopped
+   * changing from one poll to the next, so a grammar that's still
+   * being written isn't picked up half-finished.  If the new grammar
+   * can't be loaded, the old one continues to be served.
+   *
+   * @param fileName the grammar file to watch.
+   * @param initial the grammar loaded from it, which the server takes over.
+   * @param load reloads the grammar file.
+   * @param maxDepth forwarded to every SentenceGenerator.
+   */
+
+  GrammarServer(const string& fileName, Grammar *initial, grammarLoader load, int maxDepth);
+
+  /**
+   * Destructor: ~GrammarServer
+   * --------------------------
+   * Stops watching the grammar file.
+   */
+
+  ~GrammarServer();
+
+  /**
+   * Method: serve
+   * -------------
+   * Reads requests from one file descriptor and writes the responses
+   * to the other, until the input is exhausted, "quit" is requested,
+   * or a response can't be written.
+   */
+
+  void serve(int in, int out);
+
+  /**
+   * Method: listen
+   * --------------
+   * Creates a Unix domain socket at the specified path (replacing any
+   * stale socket there, but refusing to replace anything else) and
+   * serves every connection made to it, each on a thread of its own.
+   * This only returns if the socket couldn't be set up.
+   *
+   * @param socketPath where the socket should be created.
+   * @param errorMessage updated with a description of the problem.
+   * @return false.
+   */
+
+  bool listen(const string& socketPath, string& errorMessage);
+
+ private:
+
+  /**
+   * What one conversation keeps between requests: its batch buffer,
+   * and a generator over the grammar it last served, which is only
+   * replaced once the grammar is.  Holding on to the grammar keeps
+   * it alive for as long as the generator needs it.
+   */
+
+  struct conversation {
+    OutputBuffer batch;
+    shared_ptr<const Grammar> grammar;
+    unique_ptr<SentenceGenerator> generator;
+  };
+
+  string fileName;
+  grammarLoader load;
+  int maxDepth;
+  shared_ptr<const Grammar> current; // only accessed through atomic_load and atomic_store
+
+  thread watcher;
+  mutex stopLock;
+  condition_variable stopRequested;
+  bool stopping;
+
+  void watch();
+  bool respond(const string& request, conversation& state, OutputBuffer& out) const;
+
+  // marked as private so two servers can't watch and serve
+  // the same grammar (do NOT implement these).
+  GrammarServer(const GrammarServer& original);
+  GrammarServer& operator=(const GrammarServer& rhs);
+};
+
+#endif // ! __server__
@@ -0,0 +1,192 @@
+/**
+ * File: tokenizer.cc
+ * ------------------
+ * Provides the implementation of the GrammarTokenizer class.  Nearly all
+ * of the time spent tokenizing goes into finding where runs of whitespace
+ * begin and end, so on x86 that's done sixteen (SSE2) or thirty-two (AVX2)
+ * bytes at a time: each block of text is classified with a handful of
+ * vector comparisons, and the boundary is the first set bit of the
+ * resulting mask.  AVX2 is used only if the processor running the program
+ * has it, and the scalar loops handle whatever's left at the end of the
+ * text (and everything, on other processors or when compiled with
+ * -DRSG_NO_SIMD).  The structural characters '{', '}' and '\n' are found
+ * with memchr, which the C library already vectorizes.
+ */
+
+#include <string.h>
+#include "tokenizer.h"
+
+#if defined(__SSE2__) && !defined(RSG_NO_SIMD)
+#define RSG_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/**
+ * Whitespace in the sense of isspace, without the
+ * locale lookup.
+ */
+
+static inline bool isWhitespace(char ch)
+{
+  return ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r' || ch == '\v' || ch == '\f';
+}
+
+/**
+ * Each scanner consumes any whitespace at curr and then the token after
+ * it, leaving curr just past the token, and returns the token (which is
+ * empty if there was nothing but whitespace left).
+ */
+
+typedef string_view (*scanner)(const char *&curr, const char *end);
+
+/**
+ * Finishes the job for whatever the vector loops leave behind.
+ * start is where the token begins, or NULL if it hasn't been found yet.
+ */
+
+static string_view scanScalar(const char *&curr, const char *end, const char *start)
+{
+  if (start == NULL) {
+    while (curr != end && isWhitespace(*curr)) curr++;
+    start = curr;
+  }
+  while (curr != end && !isWhitespace(*curr)) curr++;
+  return string_view(start, curr - start);
+}
+
+#ifdef RSG_X86_SIMD
+
+/**
+ * Each block of text is reduced to a mask with one bit per byte, set
+ * for the whitespace bytes: ' ', and '\t' through '\r', which are the
+ * five consecutive codes 9 through 13.  Subtracting 9 (modulo 256) maps
+ * those onto 0 through 4, and the unsigned minimum with 4 leaves exactly
+ * those unchanged.  Tokens are usually short, so the block that holds
+ * the start of a token usually holds its end as well, and one mask
+ * serves for both.
+ */
+
+static string_view scanSSE2(const char *&curr, const char *end)
+{
+  const char *start = NULL;
+  while (end - curr >= 16) {
+    __m128i bytes = _mm_loadu_si128((const __m128i *) curr);
+    __m128i shifted = _mm_sub_epi8(bytes, _mm_set1_epi8(9));
+    __m128i controls = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+    __m128i spaces = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+    unsigned mask = _mm_movemask_epi8(_mm_or_si128(controls, spaces));
+    if (start == NULL) {
+      unsigned solid = ~mask & 0xFFFF;
+      if (solid == 0) {
+        curr += 16;
+        continue;
+      }
+      int offset = __builtin_ctz(solid);
+      start = curr + offset;
+      mask &= ~0u << offset;
+    }
+    if (mask != 0) {
+      curr += __builtin_ctz(mask);
+      return string_view(start, curr - start);
+    }
+    curr += 16;
+  }
+  return scanScalar(curr, end, start);
+}
+
+__attribute__((target("avx2")))
+static string_view scanAVX2(const char *&curr, const char *end)
+{
+  const char *start = NULL;
+  while (end - curr >= 32) {
+    __m256i bytes = _mm256_loadu_si256((const __m256i *) curr);
+    __m256i shifted = _mm256_sub_epi8(bytes, _mm256_set1_epi8(9));
+    __m256i controls = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+    __m256i spaces = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '));
+    unsigned mask = _mm256_movemask_epi8(_mm256_or_si256(controls, spaces));
+    if (start == NULL) {
+      unsigned solid = ~mask;
+      if (solid == 0) {
+        curr += 32;
+        continue;
+      }
+      int offset = __builtin_ctz(solid);
+      start = curr + offset;
+      mask &= ~0u << offset;
+    }
+    if (mask != 0) {
+      curr += __builtin_ctz(mask);
+      return string_view(start, curr - start);
+    }
+    curr += 32;
+  }
+  return scanScalar(curr, end, start);
+}
+
+#else
+
+static string_view scanScalar(const char *&curr, const char *end)
+{
+  return scanScalar(curr, end, NULL);
+}
+
+#endif
+
+/**
+ * Chooses the widest scanner the processor supports, once, before main runs.
+ */
+
+static scanner chooseScanner(const char *&name)
+{
+#ifdef RSG_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    name = "avx2";
+    return scanAVX2;
+  }
+  name = "sse2";
+  return scanSSE2;
+#else
+  name = "scalar";
+  return scanScalar;
+#endif
+}
+
+static const char *scannerName;
+static const scanner scan = chooseScanner(scannerName);
+
+const char *GrammarTokenizer::getInstructionSet()
+{
+  return scannerName;
+}
+
+/**
+ * Method: skipTo
+ * --------------
+ * memchr is about as fast as scanning for a single
+ * character gets.
+ */
+
+bool GrammarTokenizer::skipTo(char ch)
+{
+  const char *found = (const char *) memchr(curr, ch, end - curr);
+  if (found == NULL) {
+    curr = end;
+    return false;
+  }
+
+  curr = found;
+  return true;
+}
+
+bool GrammarTokenizer::skipPast(char ch)
+{
+  if (!skipTo(ch)) return false;
+  curr++;
+  return true;
+}
+
+string_view GrammarTokenizer::nextToken()
+{
+  return scan(curr, end);
+}
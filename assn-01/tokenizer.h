@@ -0,0 +1,93 @@
+/**
+ * File: tokenizer.h
+ * -----------------
+ * Defines the GrammarTokenizer class, which walks the text of
+ * a grammar file in a single forward pass.  Every token is handed
+ * back as a string_view into the text itself, so tokenizing never
+ * allocates or copies.
+ */
+
+#ifndef __tokenizer__
+#define __tokenizer__
+
+#include <string_view>
+using namespace std;
+
+class GrammarTokenizer {
+
+ public:
+
+  /**
+   * Constructor: GrammarTokenizer
+   * -----------------------------
+   * Positions the tokenizer at the beginning of the specified
+   * text, which must outlive the tokenizer and every token
+   * it hands back.
+   */
+
+  GrammarTokenizer(string_view text) : curr(text.data()), end(text.data() + text.size()) {}
+
+  /**
+   * Predicate Method: atEnd
+   * -----------------------
+   * Returns true if and only if all of the text has been consumed.
+   */
+
+  bool atEnd() const { return curr == end; }
+
+  /**
+   * Method: peek
+   * ------------
+   * Returns the next character without consuming it, or
+   * -1 if all of the text has been consumed.
+   */
+
+  int peek() const { return curr == end ? -1 : *curr; }
+
+  /**
+   * Methods: skipTo, skipPast
+   * -------------------------
+   * Consumes everything up to the next occurrence of the
+   * specified character.  skipTo leaves the character itself
+   * to be read next, whereas skipPast consumes it as well.
+   *
+   * @return true if the character was found, and false if the
+   *         end of the text was reached first.
+   */
+
+  bool skipTo(char ch);
+  bool skipPast(char ch);
+
+  /**
+   * Method: skipLine
+   * ----------------
+   * Consumes the rest of the current line, including the '\n'.
+   */
+
+  void skipLine() { skipPast('\n'); }
+
+  /**
+   * Method: nextToken
+   * -----------------
+   * Skips any leading whitespace and returns the maximal run
+   * of non-whitespace characters that follows, just as operator>>
+   * would.  An empty view is returned at the end of the text.
+   */
+
+  string_view nextToken();
+
+  /**
+   * Static Method: getInstructionSet
+   * --------------------------------
+   * Returns the name of the instructions used to scan the text
+   * on this machine: "avx2", "sse2" or "scalar".
+   */
+
+  static const char *getInstructionSet();
+
+ private:
+  const char *curr;
+  const char *end;
+};
+
+#endif // ! __tokenizer__
@@ -0,0 +1,290 @@
+/**
+ * File: uniform.cc
+ * ----------------
+ * Provides the implementation of the ExpansionCounts and
+ * UniformGenerator classes.  Throughout, count(A, n) is the number
+ * of derivations of nonterminal A yielding exactly n terminals, and
+ * suffixCount(i, end, n) is the number of ways the symbols from
+ * position i to the end of their production can yield exactly n
+ * terminals between them.  The two are related by
+ *
+ *     count(A, n) = sum over A's productions p of suffixCount(first symbol of p, ..., n)
+ *     suffixCount(i, end, n) = suffixCount(i + 1, end, n - 1)           if symbol i is a terminal
+ *                            = sum over m of count(X, m) * suffixCount(i + 1, end, n - m)
+ *                                                                      if symbol i is nonterminal X
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "uniform.h"
+
+ExpansionCounts::ExpansionCounts(const Grammar& grammar, int start, int maxTokens) :
+  grammar(grammar), symbols(grammar.productionBegin(0)), start(start), maxTokens(maxTokens)
+{
+  vector<int> order;
+  vector<bool> nullable;
+  if (!orderNonterminals(order, nullable)) return;
+
+  int width = maxTokens + 1;
+  nonterminalCounts.assign((size_t) grammar.getNonterminalCount() * width, 0.0L);
+  suffixCounts.assign((size_t) grammar.getSymbolTotal() * width, 0.0L);
+  vector<int> firstSolid(grammar.getProductionTotal());
+  for (size_t i = 0; i < order.size(); i++) {
+    int nonterminal = order[i];
+    for (int p = grammar.getFirstProduction(nonterminal); p < grammar.getFirstProduction(nonterminal + 1); p++) {
+      int position = grammar.getProductionOffset(p), end = grammar.getProductionOffset(p + 1);
+      while (position < end && grammar.isNonterminal(symbols[position]) && nullable[symbols[position]])
+        position++;
+      firstSolid[p] = position;
+    }
+  }
+
+  for (int tokens = 0; tokens <= maxTokens; tokens++) {
+    // The suffixes up to and including the first symbol that can't
+    // vanish are all that count(A, tokens) depends on, and the order
+    // makes sure every count(X, tokens) they need is already known.
+    for (size_t i = 0; i < order.size(); i++) {
+      int nonterminal = order[i];
+      long double total = 0;
+      for (int p = grammar.getFirstProduction(nonterminal); p < grammar.getFirstProduction(nonterminal + 1); p++) {
+        int begin = grammar.getProductionOffset(p), end = grammar.getProductionOffset(p + 1);
+        for (int position = min(firstSolid[p], end - 1); position >= begin; position--)
+          countSuffix(position, end, tokens);
+        total += suffixCount(begin, end, tokens);
+      }
+      nonterminalCounts[(size_t) nonterminal * width + tokens] = total;
+    }
+
+    // With every count(X, tokens) known, the remaining suffixes can be filled in.
+    for (size_t i = 0; i < order.size(); i++) {
+      int nonterminal = order[i];
+      for (int p = grammar.getFirstProduction(nonterminal); p < grammar.getFirstProduction(nonterminal + 1); p++) {
+        int end = grammar.getProductionOffset(p + 1);
+        for (int position = end - 1; position > firstSolid[p]; position--)
+          countSuffix(position, end, tokens);
+      }
+    }
+  }
+
+  cumulative.resize(width);
+  for (int tokens = 0; tokens <= maxTokens; tokens++)
+    cumulative[tokens] = (tokens == 0 ? 0.0L : cumulative[tokens - 1]) + count(start, tokens);
+  if (!isfinite(cumulative[maxTokens])) {
+    errorMessage = "There are too many derivations of " + string(grammar.getSymbolName(start)) +
+      " to count; try a smaller token limit.";
+  } else if (cumulative[maxTokens] == 0) {
+    errorMessage = "No sentence derived from " + string(grammar.getSymbolName(start)) + " has " +
+      to_string(maxTokens) + " or fewer terminals.";
+  }
+}
+
+/**
+ * Method: orderNonterminals
+ * -------------------------
+ * count(A, n) depends on count(X, n) whenever A has a production in
+ * which X appears and everything else can vanish (that is, derive no
+ * terminals at all).  This orders the nonterminals reachable from the
+ * start symbol so that every nonterminal follows the ones it depends
+ * on in that way.  Such an order exists unless some nonterminal
+ * depends on itself, in which case it has infinitely many derivations
+ * of some length, and false is returned.  nullable is set to record
+ * which nonterminals can vanish.
+ */
+
+bool ExpansionCounts::orderNonterminals(vector<int>& order, vector<bool>& nullable)
+{
+  int nonterminalCount = grammar.getNonterminalCount();
+  nullable.assign(nonterminalCount, false);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int nonterminal = 0; nonterminal < nonterminalCount; nonterminal++) {
+      if (nullable[nonterminal]) continue;
+      for (int p = grammar.getFirstProduction(nonterminal); p < grammar.getFirstProduction(nonterminal + 1); p++) {
+        const int32_t *curr = grammar.productionBegin(p), *end = grammar.productionEnd(p);
+        while (curr != end && grammar.isNonterminal(*curr) && nullable[*curr]) curr++;
+        if (curr == end) {
+          nullable[nonterminal] = changed = true;
+          break;
+        }
+      }
+    }
+  }
+
+  vector<bool> reachable(nonterminalCount, false);
+  vector<int> pending(1, start);
+  reachable[start] = true;
+  while (!pending.empty()) {
+    int nonterminal = pending.back();
+    pending.pop_back();
+    for (int p = grammar.getFirstProduction(nonterminal); p < grammar.getFirstProduction(nonterminal + 1); p++) {
+      for (const int32_t *curr = grammar.productionBegin(p); curr != grammar.productionEnd(p); ++curr) {
+        if (!grammar.isNonterminal(*curr) || reachable[*curr]) continue;
+        reachable[*curr] = true;
+        pending.push_back(*curr);
+      }
+    }
+  }
+
+  // waiting[A] counts the dependencies of A not yet placed in the order
+  vector<int> waiting(nonterminalCount, 0);
+  vector<vector<int> > dependents(nonterminalCount);
+  for (int nonterminal = 0; nonterminal < nonterminalCount; nonterminal++) {
+    if (!reachable[nonterminal]) continue;
+    for (int p = grammar.getFirstProduction(nonterminal); p < grammar.getFirstProduction(nonterminal + 1); p++) {
+      int solid = 0, solidSymbol = -1;
+      for (const int32_t *curr = grammar.productionBegin(p); curr != grammar.productionEnd(p); ++curr) {
+        if (grammar.isNonterminal(*curr) && nullable[*curr]) continue;
+        solid++;
+        solidSymbol = *curr;
+      }
+      for (const int32_t *curr = grammar.productionBegin(p); curr != grammar.productionEnd(p); ++curr) {
+        if (!grammar.isNonterminal(*curr)) continue;
+        if (solid == 0 || (solid == 1 && *curr == solidSymbol)) {
+          waiting[nonterminal]++;
+          dependents[*curr].push_back(nonterminal);
+        }
+      }
+    }
+  }
+
+  for (int nonterminal = 0; nonterminal < nonterminalCount; nonterminal++)
+    if (reachable[nonterminal] && waiting[nonterminal] == 0) order.push_back(nonterminal);
+  for (size_t i = 0; i < order.size(); i++) {
+    const vector<int>& next = dependents[order[i]];
+    for (size_t j = 0; j < next.size(); j++)
+      if (--waiting[next[j]] == 0) order.push_back(next[j]);
+  }
+
+  for (int nonterminal = 0; nonterminal < nonterminalCount; nonterminal++) {
+    if (reachable[nonterminal] && waiting[nonterminal] > 0) {
+      errorMessage = string(grammar.getSymbolName(nonterminal)) + " can derive itself without producing any " +
+        "terminals, so it has infinitely many derivations and can't be sampled uniformly.";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Method: countSuffix
+ * -------------------
+ * Fills in suffixCount(position, end, tokens), assuming
+ * everything it depends on has been filled in already.
+ */
+
+void ExpansionCounts::countSuffix(int position, int end, int tokens)
+{
+  int symbol = symbols[position];
+  long double total = 0;
+  if (!grammar.isNonterminal(symbol)) {
+    if (tokens > 0) total = suffixCount(position + 1, end, tokens - 1);
+  } else {
+    for (int length = 0; length <= tokens; length++)
+      total += count(symbol, length) * suffixCount(position + 1, end, tokens - length);
+  }
+
+  suffixCounts[(size_t) position * (maxTokens + 1) + tokens] = total;
+}
+
+UniformGenerator::UniformGenerator(const ExpansionCounts& counts) :
+  counts(counts), grammar(counts.grammar) {}
+
+/**
+ * Method: generate
+ * ----------------
+ * The same explicit-stack traversal SentenceGenerator uses, except that
+ * each frame also remembers how many terminals the rest of its production
+ * has been allotted, and each nonterminal is told exactly how many
+ * terminals it must yield before it chooses a production.
+ */
+
+bool UniformGenerator::generate(RandomGenerator& random, OutputBuffer& out)
+{
+  const vector<long double>& cumulative = counts.cumulative;
+  long double target = random.getRandomFraction() * cumulative.back();
+  int tokens = upper_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin();
+  if (tokens > counts.maxTokens) tokens = counts.maxTokens; // only possible through rounding
+  while (counts.count(counts.start, tokens) == 0) tokens--;
+
+  bool first = true;
+  stack.clear();
+  push(counts.start, tokens, random);
+  while (!stack.empty()) {
+    frame& top = stack.back();
+    if (top.position == top.end) {
+      stack.pop_back();
+      continue;
+    }
+
+    int symbol = counts.symbols[top.position];
+    if (grammar.isNonterminal(symbol)) {
+      int length = chooseSplit(symbol, top, random);
+      top.position++;
+      top.tokens -= length;
+      push(symbol, length, random); // top may dangle after this
+    } else {
+      if (!first) out.put(' ');
+      out.append(grammar.getSymbolName(symbol));
+      first = false;
+      top.position++;
+      top.tokens--;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Method: push
+ * ------------
+ * Chooses a production for the specified nonterminal in proportion to
+ * the number of its derivations yielding the specified number of terminals,
+ * and pushes a frame addressing its first symbol.  If rounding makes the
+ * draw fall off the end, the last production with any derivations is used.
+ */
+
+void UniformGenerator::push(int nonterminal, int tokens, RandomGenerator& random)
+{
+  long double target = random.getRandomFraction() * counts.count(nonterminal, tokens);
+  int chosen = -1;
+  for (int p = grammar.getFirstProduction(nonterminal); p < grammar.getFirstProduction(nonterminal + 1); p++) {
+    long double weight = counts.suffixCount(grammar.getProductionOffset(p), grammar.getProductionOffset(p + 1), tokens);
+    if (weight == 0) continue;
+    chosen = p;
+    if (target < weight) break;
+    target -= weight;
+  }
+
+  frame pushed = { grammar.getProductionOffset(chosen), grammar.getProductionOffset(chosen + 1), tokens };
+  stack.push_back(pushed);
+}
+
+/**
+ * Method: chooseSplit
+ * -------------------
+ * Decides how many of the terminals allotted to the rest of the top
+ * frame's production the nonterminal at its front will yield, in
+ * proportion to the number of derivations each choice leaves.  The
+ * candidates are tried from both ends toward the middle (0, n, 1, n - 1,
+ * and so on), since in practice the mass is concentrated at one end
+ * or the other, and that's what bounds the total time by O(n log n).
+ */
+
+int UniformGenerator::chooseSplit(int nonterminal, const frame& top, RandomGenerator& random) const
+{
+  long double target = random.getRandomFraction() * counts.suffixCount(top.position, top.end, top.tokens);
+  int chosen = -1;
+  for (int k = 0; k <= top.tokens; k++) {
+    int length = k % 2 == 0 ? k / 2 : top.tokens - k / 2;
+    long double weight = counts.count(nonterminal, length) *
+      counts.suffixCount(top.position + 1, top.end, top.tokens - length);
+    if (weight == 0) continue;
+    chosen = length;
+    if (target < weight) break;
+    target -= weight;
+  }
+
+  return chosen;
+}
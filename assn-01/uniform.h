@@ -0,0 +1,173 @@
+/**
+ * File: uniform.h
+ * ---------------
+ * Defines the classes behind uniform sampling, which makes every
+ * derivation of the start symbol up to some number of terminals
+ * equally likely, rather than every production of each nonterminal
+ * (which strongly favors short derivations and ignores how many
+ * sentences lie behind each choice).
+ *
+ * ExpansionCounts counts, once and for all, the derivations of every
+ * nonterminal for every sentence length up to the bound.  Those counts
+ * are read-only afterwards, so any number of UniformGenerators (one
+ * per thread, say) can share them.  Production weights are ignored in
+ * this mode, since every derivation counts the same.
+ */
+
+#ifndef __uniform__
+#define __uniform__
+
+#include <string>
+#include <vector>
+#include "grammar.h"
+#include "output.h"
+#include "random.h"
+using namespace std;
+
+class ExpansionCounts {
+
+ public:
+
+  /**
+   * Constructor: ExpansionCounts
+   * ----------------------------
+   * Counts the derivations of every nonterminal yielding exactly n
+   * terminals, for every n in [0, maxTokens], by dynamic programming
+   * over the productions.  Along the way, the same counts are kept for
+   * every suffix of every production, which is what lets a derivation
+   * be sampled without any searching.  Time and space are both
+   * proportional to the size of the grammar times (maxTokens + 1), with
+   * an extra factor of maxTokens in time for the convolutions.
+   *
+   * The counts are infinite when a nonterminal can derive itself without
+   * producing any terminals (through a cycle of unit or empty productions),
+   * so such grammars are rejected, as are grammars whose counts overflow
+   * a long double.  good() reports whether counting succeeded.
+   *
+   * @param grammar the compiled grammar, which must outlive the counts.
+   * @param start the nonterminal whose derivations are to be sampled.
+   * @param maxTokens the largest number of terminals in a sentence.
+   */
+
+  ExpansionCounts(const Grammar& grammar, int start, int maxTokens);
+
+  /**
+   * Predicate Method: good
+   * ----------------------
+   * Returns true if and only if the counts are usable, and
+   * the start symbol has at least one derivation within the bound.
+   */
+
+  bool good() const { return errorMessage.empty(); }
+
+  /**
+   * Method: getErrorMessage
+   * -----------------------
+   * Explains why good() returns false.
+   */
+
+  const string& getErrorMessage() const { return errorMessage; }
+
+  /**
+   * Methods: getStart, getMaxTokens
+   * -------------------------------
+   * Return the parameters the counts were computed for.
+   */
+
+  int getStart() const { return start; }
+  int getMaxTokens() const { return maxTokens; }
+
+  /**
+   * Method: getDerivationCount
+   * --------------------------
+   * Returns the number of derivations of the start symbol yielding
+   * exactly the specified number of terminals, or (with no argument)
+   * yielding at most getMaxTokens() of them.
+   */
+
+  long double getDerivationCount(int tokens) const { return count(start, tokens); }
+  long double getDerivationCount() const { return cumulative[maxTokens]; }
+
+ private:
+  const Grammar& grammar;
+  const int32_t *symbols;                // every production body, back to back
+  int start;
+  int maxTokens;
+  vector<long double> nonterminalCounts; // [nonterminal][tokens]
+  vector<long double> suffixCounts;      // [symbol position][tokens], for the suffix starting there
+  vector<long double> cumulative;        // derivations of start with at most n tokens
+  string errorMessage;
+
+  long double count(int nonterminal, int tokens) const
+  { return nonterminalCounts[(size_t) nonterminal * (maxTokens + 1) + tokens]; }
+  long double suffixCount(int position, int end, int tokens) const
+  { return position == end ? (tokens == 0) : suffixCounts[(size_t) position * (maxTokens + 1) + tokens]; }
+
+  bool orderNonterminals(vector<int>& order, vector<bool>& nullable);
+  void countSuffix(int position, int end, int tokens);
+
+  friend class UniformGenerator;
+};
+
+class UniformGenerator {
+
+ public:
+
+  /**
+   * Constructor: UniformGenerator
+   * -----------------------------
+   * Constructs a generator that samples derivations using the
+   * specified counts, which must be good() and outlive the generator.
+   */
+
+  UniformGenerator(const ExpansionCounts& counts);
+
+  /**
+   * Method: generate
+   * ----------------
+   * Chooses a derivation of the start symbol uniformly at random from
+   * all of those yielding at most getMaxTokens() terminals, and appends
+   * its sentence to out, with exactly one space between consecutive
+   * terminals.  Every choice along the way is made in proportion to
+   * the number of derivations it leaves open, so no choice is ever
+   * undone.  The length of the sentence is chosen first, and then each
+   * nonterminal's length is split among its production's symbols by
+   * trying the shortest and longest splits alternately, so the time is
+   * O(n log n) in the length n of the sentence at worst, and linear for
+   * typical grammars.  The probabilities are only as exact as a long
+   * double, which matters only for truly astronomical languages.
+   *
+   * @param random the source of randomness.
+   * @param out the buffer the sentence should be appended to.
+   * @return true, always: the counts guarantee that some derivation
+   *         exists, so unlike SentenceGenerator, this can't fail.
+   */
+
+  bool generate(RandomGenerator& random, OutputBuffer& out);
+
+  /**
+   * Method: getErrorMessage
+   * -----------------------
+   * Provided for symmetry with SentenceGenerator.  Uniform
+   * generation can't fail, so the message is always empty.
+   */
+
+  const string& getErrorMessage() const { return errorMessage; }
+
+ private:
+  struct frame {
+    int position;  // of the next symbol, among all of the grammar's symbols
+    int end;
+    int tokens;    // terminals still to be produced by the rest of the production
+  };
+
+  const ExpansionCounts& counts;
+  const Grammar& grammar;
+  vector<frame> stack;
+  string errorMessage;
+
+  void push(int nonterminal, int tokens, RandomGenerator& random);
+  int chooseSplit(int nonterminal, const frame& top, RandomGenerator& random) const;
+};
+
+#endif // ! __uniform__
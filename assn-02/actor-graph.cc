@@ -0,0 +1,171 @@
+#include "actor-graph.h"
+using namespace std;
+
+actorGraph::actorGraph(const imdb& db) : db(db), indexed(db.hasIndex())
+{
+  size_t actorCount = indexed ? db.getActorCount() : db.getActorFileSize();
+  size_t movieCount = indexed ? db.getMovieCount() : db.getMovieFileSize();
+  fromStart.reachedActors.resize(actorCount);
+  fromStart.seenMovies.resize(movieCount);
+  fromFinish.reachedActors.resize(actorCount);
+  fromFinish.seenMovies.resize(movieCount);
+}
+
+/**
+ * Returns the films starring the specified actor, or the
+ * cast of the specified film, from the index if there is
+ * one, and from the records themselves if there isn't.
+ */
+
+const int *actorGraph::getCredits(int actor, int& count) const
+{
+  return indexed ? db.getCreditIds(actor, count) : db.getCreditOffsets(actor, count);
+}
+
+const int *actorGraph::getCast(int movie, int& count) const
+{
+  return indexed ? db.getCastIds(movie, count) : db.getCastOffsets(movie, count);
+}
+
+/**
+ * Returns the name of the specified actor, or the title
+ * and year of the specified film.
+ */
+
+const char *actorGraph::getActorName(int actor) const
+{
+  return db.getActorName(indexed ? db.getActorOffsetById(actor) : actor);
+}
+
+film actorGraph::getFilm(int movie) const
+{
+  return db.getFilm(indexed ? db.getMovieOffsetById(movie) : movie);
+}
+
+/**
+ * Readies the specified side to search outward from
+ * the specified actor, who makes up its first frontier.
+ */
+
+void actorGraph::beginSide(searchSide& side, int actor)
+{
+  visit origin = { actor, -1, -1 };
+  side.visits.push_back(origin);
+  side.reachedActors[actor] = true;
+  side.frontierStart = 0;
+  side.hops = 0;
+}
+
+/**
+ * Clears every bit the last search set, so the bitsets needn't be
+ * reallocated (or cleared in full) before the next one.
+ */
+
+void actorGraph::endSide(searchSide& side)
+{
+  for (size_t i = 0; i < side.visits.size(); i++)
+    side.reachedActors[side.visits[i].actor] = false;
+  for (size_t i = 0; i < side.seenMovieList.size(); i++)
+    side.seenMovies[side.seenMovieList[i]] = false;
+  side.visits.clear();
+  side.seenMovieList.clear();
+}
+
+/**
+ * Expands every actor in the frontier of one side by one hop, and
+ * returns the position (in that side's visits) of the first actor it
+ * reaches whom the other side has already reached, or -1 if there's no
+ * such actor.  Had the sides shared anyone before, the search would
+ * have stopped there, so anyone they share now is in the other side's
+ * frontier, and any one of them makes for a path of the same length.
+ */
+
+int actorGraph::expandFrontier(searchSide& side, const searchSide& other)
+{
+  size_t frontierEnd = side.visits.size();
+  for (size_t i = side.frontierStart; i < frontierEnd; i++) {
+    int numMovies;
+    const int *movies = getCredits(side.visits[i].actor, numMovies);
+    for (int j = 0; j < numMovies; j++) {
+      if (side.seenMovies[movies[j]]) continue;
+      side.seenMovies[movies[j]] = true;
+      side.seenMovieList.push_back(movies[j]);
+      int numActors;
+      const int *cast = getCast(movies[j], numActors);
+      for (int k = 0; k < numActors; k++) {
+        if (side.reachedActors[cast[k]]) continue;
+        side.reachedActors[cast[k]] = true;
+        visit reached = { cast[k], movies[j], (int) i };
+        side.visits.push_back(reached);
+        if (other.reachedActors[cast[k]]) return side.visits.size() - 1;
+      }
+    }
+  }
+
+  side.frontierStart = frontierEnd;
+  side.hops++;
+  return -1;
+}
+
+/**
+ * Returns the position in the specified side's visits of
+ * the specified actor, who must have been reached.
+ */
+
+int actorGraph::findVisit(const searchSide& side, int actor) const
+{
+  for (size_t i = side.visits.size(); i > 0; i--)
+    if (side.visits[i - 1].actor == actor) return i - 1;
+  return -1;
+}
+
+/**
+ * Builds the path through the actor where the two sides met.  The
+ * half from the meeting back to the start is built first and then
+ * reversed, and the half from the meeting on to the finish is
+ * appended to it.
+ */
+
+void actorGraph::buildPath(int startVisit, int finishVisit, path& result) const
+{
+  result = path(getActorName(fromStart.visits[startVisit].actor));
+  for (int i = startVisit; fromStart.visits[i].parent != -1; i = fromStart.visits[i].parent) {
+    const visit& step = fromStart.visits[i];
+    result.addConnection(getFilm(step.movie), getActorName(fromStart.visits[step.parent].actor));
+  }
+  result.reverse();
+  for (int i = finishVisit; fromFinish.visits[i].parent != -1; i = fromFinish.visits[i].parent) {
+    const visit& step = fromFinish.visits[i];
+    result.addConnection(getFilm(step.movie), getActorName(fromFinish.visits[step.parent].actor));
+  }
+}
+
+bool actorGraph::findShortestPath(const string& start, const string& finish, int maxLength, path& result)
+{
+  int startActor = indexed ? db.getActorId(start) : db.getActorOffset(start);
+  int finishActor = indexed ? db.getActorId(finish) : db.getActorOffset(finish);
+  if (startActor == -1 || finishActor == -1) return false;
+
+  beginSide(fromStart, startActor);
+  beginSide(fromFinish, finishActor);
+  bool found = startActor == finishActor;
+  if (found) result = path(start);
+  while (!found && fromStart.hops + fromFinish.hops < maxLength &&
+         fromStart.frontierStart < fromStart.visits.size() &&
+         fromFinish.frontierStart < fromFinish.visits.size()) {
+    bool expandStart = fromStart.visits.size() - fromStart.frontierStart <=
+                       fromFinish.visits.size() - fromFinish.frontierStart;
+    searchSide& side = expandStart ? fromStart : fromFinish;
+    searchSide& other = expandStart ? fromFinish : fromStart;
+    int meeting = expandFrontier(side, other);
+    if (meeting == -1) continue;
+    int otherMeeting = findVisit(other, side.visits[meeting].actor);
+    if (expandStart) buildPath(meeting, otherMeeting, result);
+    else buildPath(otherMeeting, meeting, result);
+    found = true;
+  }
+
+  endSide(fromStart);
+  endSide(fromFinish);
+  return found;
+}
@@ -0,0 +1,97 @@
+#ifndef __actor_graph__
+#define __actor_graph__
+
+#include "imdb.h"
+#include "path.h"
+#include <vector>
+using namespace std;
+
+/**
+ * Class: actorGraph
+ * -----------------
+ * Searches the actor/movie graph stored in an imdb for shortest paths.
+ * Actors and films are identified by the byte offsets of their records
+ * in the imdb's files rather than by name, so marking someone as seen
+ * is a matter of setting one bit, and following a link is a matter of
+ * reading one integer.  Names are only looked up again to build the
+ * path that's found.  If the imdb has an adjacency index, actors and
+ * films are identified by their numbers instead, and the search walks
+ * the index's arrays without decoding any records at all.
+ */
+
+class actorGraph {
+
+ public:
+
+  /**
+   * Constructor: actorGraph
+   * -----------------------
+   * Constructs a graph layered on top of the specified imdb, which
+   * must outlive it.  The bitsets (sized to the imdb's files, or to
+   * its counts if it has an index) are allocated once, here, and
+   * reused by every search.
+   *
+   * @param db the imdb whose actors and films make up the graph.
+   */
+
+  actorGraph(const imdb& db);
+
+  /**
+   * Method: findShortestPath
+   * ------------------------
+   * Searches for a shortest path of at most maxLength movies from one
+   * actor/actress to another, expanding outward from both at once.
+   *
+   * @param start the name of the actor/actress the path starts with.
+   * @param finish the name of the actor/actress the path ends with.
+   * @param maxLength the greatest number of movies the path may have.
+   * @param result updated to hold the path, if one is found.
+   * @return true if and only if a path was found.
+   */
+
+  bool findShortestPath(const string& start, const string& finish, int maxLength, path& result);
+
+ private:
+
+  // how one side of the search reached an actor: the actor, the film
+  // connecting them to whoever came before, and that person's
+  // position in the same side's visits (or -1 for where the side started).
+  struct visit {
+    int actor;
+    int movie;
+    int parent;
+  };
+
+  // one side of the search.  visits lists everyone the side has reached, in
+  // the order reached, so [frontierStart, visits.size()) is its frontier.
+  struct searchSide {
+    vector<visit> visits;
+    vector<bool> reachedActors;    // indexed by actor
+    vector<bool> seenMovies;       // indexed by film
+    vector<int> seenMovieList;     // so seenMovies can be cleared quickly
+    size_t frontierStart;
+    int hops;
+  };
+
+  const imdb& db;
+  bool indexed;    // actors and films are numbers rather than offsets
+  searchSide fromStart;
+  searchSide fromFinish;
+
+  const int *getCredits(int actor, int& count) const;
+  const int *getCast(int movie, int& count) const;
+  const char *getActorName(int actor) const;
+  film getFilm(int movie) const;
+  void beginSide(searchSide& side, int actor);
+  void endSide(searchSide& side);
+  int expandFrontier(searchSide& side, const searchSide& other);
+  int findVisit(const searchSide& side, int actor) const;
+  void buildPath(int startVisit, int finishVisit, path& result) const;
+
+  // marked as private so graphs aren't copied by accident
+  // (do NOT implement these).
+  actorGraph(const actorGraph& original);
+  actorGraph& operator=(const actorGraph& rhs);
+};
+
+#endif
@@ -0,0 +1,38 @@
+#include <iostream>
+#include <string>
+#include "imdb.h"
+using namespace std;
+
+/**
+ * Serves as the main entry point for the build-index executable, which
+ * writes the adjacency index for the imdb data files, so that the imdb
+ * (and six-degrees) can walk the actor/movie graph without decoding
+ * records.  The index has to be rebuilt whenever the data files change;
+ * until it is, the imdb notices the mismatch and ignores it.
+ *
+ * @param argc the number of tokens passed to the command line.
+ * @param argv the C strings making up the full command line.  If
+ *             present, argv[1] names the directory housing the data
+ *             files, and otherwise the usual directory is assumed.
+ * @return 0 if the index was written, and 1 otherwise.
+ */
+
+int main(int argc, const char *argv[])
+{
+  string directory = argc > 1 ? argv[1] : determinePathToData();
+  imdb db(directory);
+  if (!db.good()) {
+    cout << "Failed to properly initialize the imdb database in \"" << directory << "\"." << endl;
+    return 1;
+  }
+
+  string indexFileName = directory + "/" + imdb::kIndexFileName;
+  if (!db.writeIndex(indexFileName)) {
+    cout << "Failed to write the index to \"" << indexFileName << "\"." << endl;
+    return 1;
+  }
+
+  cout << "Indexed " << db.getActorCount() << " actors and actresses and "
+       << db.getMovieCount() << " films in \"" << indexFileName << "\"." << endl;
+  return 0;
+}
@@ -6,9 +6,14 @@ using namespace std;
 #include <unistd.h>
 #include "imdb.h"
 #include <string.h>
+#include <algorithm>
+#include <fstream>
 
 const char *const imdb::kActorFileName = "actordata";
 const char *const imdb::kMovieFileName = "moviedata";
+const char *const imdb::kIndexFileName = "graphindex";
+const int32_t imdb::kIndexMagic = 0x58444e49; // "INDX"
+const int32_t imdb::kIndexVersion = 1;
 
 /* Method Prototypes */
 film create_film(string title, int year);
@@ -23,51 +28,152 @@ imdb::imdb(const string& directory)
   
   actorFile = acquireFileMap(actorFileName, actorInfo);
   movieFile = acquireFileMap(movieFileName, movieInfo);
+  creditStarts = creditIds = castStarts = castIds = NULL;
+  const void *indexFile = acquireFileMap(directory + "/" + kIndexFileName, indexInfo);
+  if (good() && indexFile != NULL) attachIndex(indexFile);
 }
 
-/* file struct, which consists of const void* (aka actorFile) and string name*/
+/**
+ * Returns true if and only if the specified array of count
+ * entries never decreases, starts at 0 and ends at last.
+ */
+
+static bool isRunBoundaries(const int32_t *array, int count, int32_t last)
+{
+  if (count <= 0 || array[0] != 0 || array[count - 1] != last) return false;
+  for (int i = 1; i < count; i++)
+    if (array[i] < array[i - 1]) return false;
+  return true;
+}
+
+/**
+ * Returns true if and only if every one of the count
+ * entries of the specified array is in [0, limit).
+ */
+
+static bool isWithin(const int32_t *array, int count, int32_t limit)
+{
+  for (int i = 0; i < count; i++)
+    if (array[i] < 0 || array[i] >= limit) return false;
+  return true;
+}
+
+/**
+ * Points the index arrays into the specified mapped index, but only if
+ * its header checks out, its size is exactly what the header implies,
+ * and its arrays are well formed: every run of ids lies within the
+ * id array, and every id names an actual film or actor/actress.  The
+ * arrays are checked once, here, so that getCreditIds and getCastIds
+ * can trust them.  Otherwise the index is left unattached, and
+ * hasIndex() returns false.
+ */
+
+void imdb::attachIndex(const void *indexFile)
+{
+  if (indexInfo.fileSize < sizeof(indexHeader)) return;
+  const indexHeader *header = (const indexHeader *) indexFile;
+  if (header->magic != kIndexMagic || header->version != kIndexVersion ||
+      header->actorCount != getActorCount() || header->movieCount != getMovieCount() ||
+      header->actorFileSize != (int64_t) actorInfo.fileSize ||
+      header->movieFileSize != (int64_t) movieInfo.fileSize ||
+      header->creditCount < 0 || header->castCount < 0) return;
+  size_t expectedSize = sizeof(indexHeader) + sizeof(int32_t) *
+    ((size_t) header->actorCount + 1 + header->creditCount + header->movieCount + 1 + header->castCount);
+  if (indexInfo.fileSize != expectedSize) return;
+
+  const int32_t *starts = (const int32_t *) (header + 1);
+  const int32_t *ids = starts + header->actorCount + 1;
+  if (!isRunBoundaries(starts, header->actorCount + 1, header->creditCount) ||
+      !isWithin(ids, header->creditCount, header->movieCount)) return;
+  const int32_t *movieStarts = ids + header->creditCount;
+  const int32_t *movieIds = movieStarts + header->movieCount + 1;
+  if (!isRunBoundaries(movieStarts, header->movieCount + 1, header->castCount) ||
+      !isWithin(movieIds, header->castCount, header->actorCount)) return;
+
+  creditStarts = starts;
+  creditIds = ids;
+  castStarts = movieStarts;
+  castIds = movieIds;
+}
+
+/**
+ * Returns the number of the record at the specified offset, given the
+ * (offset, number) pairs of every record sorted by offset.
+ */
+
+static int32_t findId(const vector<pair<int, int32_t> >& ids, int offset)
+{
+  return lower_bound(ids.begin(), ids.end(), make_pair(offset, (int32_t) 0))->second;
+}
+
+bool imdb::writeIndex(const string& fileName) const
+{
+  vector<pair<int, int32_t> > actorIds, movieIds;
+  for (int32_t id = 0; id < getActorCount(); id++) actorIds.push_back(make_pair(getActorOffsetById(id), id));
+  for (int32_t id = 0; id < getMovieCount(); id++) movieIds.push_back(make_pair(getMovieOffsetById(id), id));
+  sort(actorIds.begin(), actorIds.end());
+  sort(movieIds.begin(), movieIds.end());
+
+  vector<int32_t> actorStarts(1, 0), credits;
+  for (int id = 0; id < getActorCount(); id++) {
+    int count;
+    const int *offsets = getCreditOffsets(getActorOffsetById(id), count);
+    for (int i = 0; i < count; i++) credits.push_back(findId(movieIds, offsets[i]));
+    actorStarts.push_back(credits.size());
+  }
+  vector<int32_t> movieStarts(1, 0), cast;
+  for (int id = 0; id < getMovieCount(); id++) {
+    int count;
+    const int *offsets = getCastOffsets(getMovieOffsetById(id), count);
+    for (int i = 0; i < count; i++) cast.push_back(findId(actorIds, offsets[i]));
+    movieStarts.push_back(cast.size());
+  }
+
+  indexHeader header = { kIndexMagic, kIndexVersion, getActorCount(), getMovieCount(),
+                         (int32_t) credits.size(), (int32_t) cast.size(),
+                         (int64_t) actorInfo.fileSize, (int64_t) movieInfo.fileSize };
+  ofstream out(fileName.c_str(), ios::binary | ios::trunc);
+  out.write((const char *) &header, sizeof(header));
+  out.write((const char *) actorStarts.data(), sizeof(int32_t) * actorStarts.size());
+  out.write((const char *) credits.data(), sizeof(int32_t) * credits.size());
+  out.write((const char *) movieStarts.data(), sizeof(int32_t) * movieStarts.size());
+  out.write((const char *) cast.data(), sizeof(int32_t) * cast.size());
+  out.close();
+  return !out.fail();
+}
+
+/* file struct, which consists of const void* (aka actorFile) and the name being searched for*/
 struct file{
   const void* file;
-  string name;
+  const char* name;
 };
 
-/* movie_file struct, which consists of const void* (aka movieFile) and film movie*/
+/* movie_file struct, which consists of const void* (aka movieFile) and the film being searched for*/
 struct movie_file{
   const void* file;
-  film movie;
+  const film* movie;
 };
 
-/* Comparison method for getCredits method */
+/* Comparison method for getCredits method, comparing names in place with no copying */
 int compare_Fn(const void* keyStruct, const void* compare)
 {
-  file* actor_struct = (file*)(keyStruct);
-  int offset = *(int*)compare;
-  char* second_str = (char*)actor_struct->file + offset;
-  string str2(second_str);
-  if(actor_struct->name < str2){
-    return -1;
-  }else if(actor_struct->name == str2){
-    return 0;
-  }else{
-    return 1;
-  }
+  const file* actor_struct = (const file*)(keyStruct);
+  int offset = *(const int*)compare;
+  return strcmp(actor_struct->name, (const char*)actor_struct->file + offset);
 }
 
-/* Comparison method for getCast method */
+/* Comparison method for getCast method, comparing the title and then the year byte in place */
 int compare_fn(const void* keyStruct, const void* compare){
-  movie_file* film_struct = (movie_file*)keyStruct;
-  int compare_offset = *(int*)compare;
-  film compare_film;
-  char* film_info = (char*)film_struct->file;
-  get_movie_info(film_info, compare_offset, compare_film);
-  film key = film_struct->movie;
-  if(key < compare_film){
-    return -1;
-  }else if(key == compare_film){
-    return 0;
-  }else{
-    return 1;
+  const movie_file* film_struct = (const movie_file*)keyStruct;
+  int compare_offset = *(const int*)compare;
+  const char* compare_title = (const char*)film_struct->file + compare_offset;
+  int result = strcmp(film_struct->movie->title.c_str(), compare_title);
+  if(result != 0){
+    return result;
   }
+  //the year byte follows the title's null character
+  int compare_year = 1900 + (int)compare_title[film_struct->movie->title.size() + 1];
+  return (film_struct->movie->year > compare_year) - (film_struct->movie->year < compare_year);
 }
 
 bool imdb::good() const
@@ -76,18 +182,32 @@ bool imdb::good() const
 	    (movieInfo.fd == -1) ); 
 }
  
-bool imdb::getCredits(const string& player, vector<film>& films) const 
+int imdb::getActorId(const string& player) const
 {
   file key;
   key.file = actorFile;
-  key.name = player;
-  int* result = (int*)bsearch((const void*)&key, (const void*)((int*)actorFile), *(int*)actorFile, sizeof(int), compare_Fn);
+  key.name = player.c_str();
+  //the offsets start just past the count of actors
+  int* result = (int*)bsearch((const void*)&key, (const void*)((int*)actorFile + 1), *(int*)actorFile, sizeof(int), compare_Fn);
   if(result == NULL){
-    return false;
+    return -1;
   }
-  int actor_offset = *result;
-  //moving to info about actor by counting actor_offset number of bytes from actorFile
-  char* actor_info = (char*)actorFile + actor_offset;
+  return result - ((int*)actorFile + 1);
+}
+
+int imdb::getActorOffset(const string& player) const
+{
+  int actor_id = getActorId(player);
+  if(actor_id == -1){
+    return -1;
+  }
+  return getActorOffsetById(actor_id);
+}
+
+const int *imdb::getCreditOffsets(int actorOffset, int& count) const
+{
+  //moving to info about actor by counting actorOffset number of bytes from actorFile
+  char* actor_info = (char*)actorFile + actorOffset;
   //number of bytes needed to encode information
   int num_bytes = 0;
   //skipping actor's name and null character
@@ -95,15 +215,47 @@ bool imdb::getCredits(const string& player, vector<film>& films) const
   actor_info += (strlen(actor_info) + 1); 
   check_is_even(num_bytes, actor_info);
   //getting number of movies actor has played in
-  short num_movies = *(short*)actor_info; 
+  count = *(short*)actor_info; 
   check_divisible_by_four(num_bytes, actor_info);
-  for(int i = 0; i < (int)num_movies; i++){
-    //pointer arithmetic
-    int movie_offset = *(int*)(actor_info + i * sizeof(int));
-    film newFilm;
-    char* movie_info = (char*)movieFile;
-    get_movie_info(movie_info, movie_offset, newFilm);
-    films.push_back(newFilm);
+  return (const int*)actor_info;
+}
+
+const char *imdb::getActorName(int actorOffset) const
+{
+  return (const char*)actorFile + actorOffset;
+}
+
+film imdb::getFilm(int movieOffset) const
+{
+  film movie;
+  char* movie_info = (char*)movieFile;
+  get_movie_info(movie_info, movieOffset, movie);
+  return movie;
+}
+
+bool imdb::getCredits(const string& player, creditList& credits) const
+{
+  int actor_offset = getActorOffset(player);
+  if(actor_offset == -1){
+    credits = creditList();
+    return false;
+  }
+  int num_movies;
+  const int* movie_offsets = getCreditOffsets(actor_offset, num_movies);
+  credits = creditList((const char*)movieFile, movie_offsets, num_movies);
+  return true;
+}
+
+/* Copies each credit out of the mapped file */
+bool imdb::getCredits(const string& player, vector<film>& films) const 
+{
+  creditList credits;
+  if(!getCredits(player, credits)){
+    return false;
+  }
+  for(creditList::iterator curr = credits.begin(); curr != credits.end(); ++curr){
+    filmRecord record = *curr;
+    films.push_back(create_film(string(record.title), record.year - 1900));
   }
   return true;
 }
@@ -143,18 +295,39 @@ void get_movie_info(char* &info, int offset, film &film){
   film = create_film(title, year);
 }
 
-bool imdb::getCast(const film& movie, vector<string>& players) const 
+bool imdb::getCast(const film& movie, castList& players) const
 {
   movie_file file_struct;
   file_struct.file = movieFile;
-  file_struct.movie = movie;
+  file_struct.movie = &movie;
   int* result = (int*)bsearch((const void*)&file_struct, (const void*)((int*)movieFile + 1), *(int*)movieFile, sizeof(int), compare_fn);
   if(result == NULL){
+    players = castList();
     return false;
   }
-  int movie_offset = *result;
-  //moving to info about movie by counting actor_offset number of bytes from movieFile
-  char* movie_info = (char*)movieFile + movie_offset;
+  int num_actors;
+  const int* actor_offsets = getCastOffsets(*result, num_actors);
+  players = castList((const char*)actorFile, actor_offsets, num_actors);
+  return true;
+}
+
+/* Copies each cast member's name out of the mapped file */
+bool imdb::getCast(const film& movie, vector<string>& players) const 
+{
+  castList cast;
+  if(!getCast(movie, cast)){
+    return false;
+  }
+  for(castList::iterator curr = cast.begin(); curr != cast.end(); ++curr){
+    players.push_back(string((*curr).name));
+  }
+  return true;
+}
+
+const int *imdb::getCastOffsets(int movieOffset, int& count) const
+{
+  //moving to info about movie by counting movieOffset number of bytes from movieFile
+  char* movie_info = (char*)movieFile + movieOffset;
   //number of bytes needed to encode information
   int num_bytes = 0;
   //skipping movie's name, null character and one byte of year
@@ -162,22 +335,16 @@ bool imdb::getCast(const film& movie, vector<string>& players) const
   movie_info += (strlen(movie_info) + 2);
   check_is_even(num_bytes, movie_info);
   //getting number of actors in this movie
-  short num_actors = *(short*)movie_info;
+  count = *(short*)movie_info;
   check_divisible_by_four(num_bytes, movie_info);
-  for(int i = 0; i < (int)num_actors; i++){
-    //pointer arithmetic
-    int actor_offset = *(int*)(movie_info + i * sizeof(int));
-    char* actor_name = (char*)actorFile + actor_offset;
-    string name(actor_name);
-    players.push_back(name);
-  }  
-  return true;
+  return (const int*)movie_info;
 }
 
 imdb::~imdb()
 {
   releaseFileMap(actorInfo);
   releaseFileMap(movieInfo);
+  releaseFileMap(indexInfo);
 }
 
 // ignore everything below... it's all UNIXy stuff in place to make a file look like
@@ -185,10 +352,12 @@ imdb::~imdb()
 const void *imdb::acquireFileMap(const string& fileName, struct fileInfo& info)
 {
   struct stat stats;
-  stat(fileName.c_str(), &stats);
-  info.fileSize = stats.st_size;
+  info.fileSize = stat(fileName.c_str(), &stats) == 0 ? stats.st_size : 0;
   info.fd = open(fileName.c_str(), O_RDONLY);
-  return info.fileMap = mmap(0, info.fileSize, PROT_READ, MAP_SHARED, info.fd, 0);
+  if (info.fd == -1) return info.fileMap = NULL; // the index, at least, needn't be there
+  info.fileMap = mmap(0, info.fileSize, PROT_READ, MAP_SHARED, info.fd, 0);
+  if (info.fileMap == MAP_FAILED) info.fileMap = NULL;
+  return info.fileMap;
 }
 
 void imdb::releaseFileMap(struct fileInfo& info)
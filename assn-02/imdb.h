@@ -3,9 +3,95 @@
 
 #include "imdb-utils.h"
 #include <string>
+#include <string_view>
 #include <vector>
+#include <stdint.h>
 using namespace std;
 
+/**
+ * Convenience structs: filmRecord, playerRecord
+ * ---------------------------------------------
+ * Describe a film or an actor/actress in place: the title or name views
+ * the bytes of the mapped file directly, and the offset is that of the
+ * record within its file.  Nothing is copied, so a record is only good
+ * for as long as the imdb it came from.
+ */
+
+struct filmRecord {
+  string_view title;
+  int year;
+  int offset;
+};
+
+struct playerRecord {
+  string_view name;
+  int offset;
+};
+
+/**
+ * Functions: decodeRecord
+ * -----------------------
+ * Fills in the specified record from the bytes at the specified
+ * offset into the specified file.  A movie record leads with the
+ * title, followed by a single byte holding the year less 1900.
+ */
+
+inline void decodeRecord(const char *file, int offset, filmRecord& record)
+{
+  record.title = string_view(file + offset);
+  record.year = 1900 + (int) file[offset + record.title.size() + 1];
+  record.offset = offset;
+}
+
+inline void decodeRecord(const char *file, int offset, playerRecord& record)
+{
+  record.name = string_view(file + offset);
+  record.offset = offset;
+}
+
+/**
+ * Class: recordList
+ * -----------------
+ * An iterable view of an array of offsets stored in one mapped file
+ * (a list of credits or a cast), which yields the records those
+ * offsets refer to in another.  Records are decoded one at a time,
+ * as they're visited, and nothing is ever allocated.
+ */
+
+template <typename Record>
+class recordList {
+
+ public:
+
+  class iterator {
+   public:
+    iterator(const char *file, const int *curr) : file(file), curr(curr) {}
+    Record operator*() const { Record record; decodeRecord(file, *curr, record); return record; }
+    iterator& operator++() { ++curr; return *this; }
+    bool operator==(const iterator& rhs) const { return curr == rhs.curr; }
+    bool operator!=(const iterator& rhs) const { return curr != rhs.curr; }
+   private:
+    const char *file;
+    const int *curr;
+  };
+
+  recordList() : file(NULL), offsets(NULL), count(0) {}
+  recordList(const char *file, const int *offsets, int count) : file(file), offsets(offsets), count(count) {}
+
+  int size() const { return count; }
+  Record operator[](int i) const { Record record; decodeRecord(file, offsets[i], record); return record; }
+  iterator begin() const { return iterator(file, offsets); }
+  iterator end() const { return iterator(file, offsets + count); }
+
+ private:
+  const char *file;     // the file holding the records
+  const int *offsets;   // the offsets, in the other file
+  int count;
+};
+
+typedef recordList<filmRecord> creditList;
+typedef recordList<playerRecord> castList;
+
 class imdb {
   
  public:
@@ -74,6 +160,132 @@ class imdb {
 
   bool getCast(const film& movie, vector<string>& players) const;
 
+  /**
+   * Methods: getCredits, getCast
+   * ----------------------------
+   * Like the versions above, except that the credits or cast are
+   * returned as a view of the mapped files rather than copied into
+   * a vector, so there's no allocation at all.  The views stay good
+   * for as long as the imdb does.  If the actor/actress or movie
+   * isn't in the database, the view is left empty.
+   */
+
+  bool getCredits(const string& player, creditList& credits) const;
+  bool getCast(const film& movie, castList& players) const;
+
+  /**
+   * Method: getActorOffset
+   * ----------------------
+   * Returns the byte offset of the specified actor/actress's record
+   * within the actor file, or -1 if the actor/actress isn't in the
+   * database.  Offsets identify actors and actresses (and, within the
+   * movie file, films) uniquely, and cost nothing to compare, so
+   * clients that search the graph can work with them instead of names.
+   */
+
+  int getActorOffset(const string& player) const;
+
+  /**
+   * Methods: getActorFileSize, getMovieFileSize
+   * -------------------------------------------
+   * Returns the size, in bytes, of the actor and movie files.
+   * Every offset is less than the size of its file, so these
+   * bound the arrays (or bitsets) that clients index by offset.
+   */
+
+  size_t getActorFileSize() const { return actorInfo.fileSize; }
+  size_t getMovieFileSize() const { return movieInfo.fileSize; }
+
+  /**
+   * Methods: getCreditOffsets, getCastOffsets
+   * -----------------------------------------
+   * Returns the address of the array of offsets (into the movie file)
+   * of the films starring the actor/actress at the specified offset,
+   * or of the offsets (into the actor file) of the cast of the film at
+   * the specified offset, and sets count to the length of that array.
+   * The array lives in the mapped file itself, so nothing is copied.
+   */
+
+  const int *getCreditOffsets(int actorOffset, int& count) const;
+  const int *getCastOffsets(int movieOffset, int& count) const;
+
+  /**
+   * Methods: getActorName, getFilm
+   * ------------------------------
+   * Returns the name of the actor/actress, or the title and year
+   * of the film, whose record is at the specified offset.
+   */
+
+  const char *getActorName(int actorOffset) const;
+  film getFilm(int movieOffset) const;
+
+  /**
+   * Methods: getActorCount, getMovieCount, getActorId
+   * -------------------------------------------------
+   * Actors and actresses (and films) are also numbered densely, from 0,
+   * in the order the data files list them.  getActorId returns the
+   * number of the specified actor/actress, or -1 if there's no such
+   * person in the database.
+   */
+
+  int getActorCount() const { return *(const int *) actorFile; }
+  int getMovieCount() const { return *(const int *) movieFile; }
+  int getActorId(const string& player) const;
+
+  /**
+   * Methods: getActorOffsetById, getMovieOffsetById
+   * -----------------------------------------------
+   * Returns the offset of the record of the actor/actress
+   * (or the film) with the specified number.
+   */
+
+  int getActorOffsetById(int actorId) const { return ((const int *) actorFile)[actorId + 1]; }
+  int getMovieOffsetById(int movieId) const { return ((const int *) movieFile)[movieId + 1]; }
+
+  /**
+   * Predicate Method: hasIndex
+   * --------------------------
+   * Returns true if and only if the directory also held an adjacency index
+   * (as written by writeIndex) that matches the data files.  The index is
+   * optional: without it, getCreditIds and getCastIds can't be used, but
+   * everything else works as usual.
+   */
+
+  bool hasIndex() const { return creditStarts != NULL; }
+
+  /**
+   * Methods: getCreditIds, getCastIds
+   * ---------------------------------
+   * Like getCreditOffsets and getCastOffsets, except that films and
+   * actors/actresses are identified by number, and that the arrays
+   * come from the index, so the records needn't be decoded at all.
+   * Only to be used if hasIndex() returns true.
+   */
+
+  const int32_t *getCreditIds(int actorId, int& count) const
+  { count = creditStarts[actorId + 1] - creditStarts[actorId]; return creditIds + creditStarts[actorId]; }
+  const int32_t *getCastIds(int movieId, int& count) const
+  { count = castStarts[movieId + 1] - castStarts[movieId]; return castIds + castStarts[movieId]; }
+
+  /**
+   * Method: writeIndex
+   * ------------------
+   * Writes the adjacency index of the receiving imdb to the specified
+   * file.  The index holds the credits of every actor/actress and the
+   * cast of every film as numbers rather than offsets, in compressed
+   * sparse row form: each list is a run of one long array, and a second
+   * array records where each run starts.  An imdb constructed on a
+   * directory holding the index (under the name kIndexFileName) maps it
+   * alongside the data files.
+   *
+   * @param fileName the name of the file to be written.
+   * @return true if and only if the index was written in full.
+   */
+
+  bool writeIndex(const string& fileName) const;
+
+  static const char *const kIndexFileName;
+
   /**
    * Destructor: ~imdb
    * -----------------
@@ -88,6 +300,29 @@ class imdb {
   static const char *const kMovieFileName;
   const void *actorFile;
   const void *movieFile;
+
+  // the index, laid out as an indexHeader followed by the arrays
+  // creditStarts[actorCount + 1], creditIds[creditCount],
+  // castStarts[movieCount + 1] and castIds[castCount].
+  struct indexHeader {
+    int32_t magic;
+    int32_t version;
+    int32_t actorCount;
+    int32_t movieCount;
+    int32_t creditCount;
+    int32_t castCount;
+    int64_t actorFileSize;   // so an index for other data files is ignored
+    int64_t movieFileSize;
+  };
+
+  static const int32_t kIndexMagic;
+  static const int32_t kIndexVersion;
+  const int32_t *creditStarts;  // all NULL unless there's an index
+  const int32_t *creditIds;
+  const int32_t *castStarts;
+  const int32_t *castIds;
+
+  void attachIndex(const void *indexFile);
   
   // everything below here is complicated and needn't be touched.
   // you're free to investigate, but you're on your own.
@@ -95,7 +330,7 @@ class imdb {
     int fd;
     size_t fileSize;
     const void *fileMap;
-  } actorInfo, movieInfo;
+  } actorInfo, movieInfo, indexInfo;
 
   static const void *acquireFileMap(const string& fileName, struct fileInfo& info);
   static void releaseFileMap(struct fileInfo& info);
@@ -1,10 +1,10 @@
 #include <vector>
-#include <list>
 #include <set>
 #include <string>
 #include <iostream>
 #include <iomanip>
 #include "imdb.h"
+#include "actor-graph.h"
 #include "path.h"
 using namespace std;
 
@@ -30,52 +30,31 @@ static string promptForActor(const string& prompt, const imdb& db)
     cout << prompt << " [or <enter> to quit]: ";
     getline(cin, response);
     if (response == "") return "";
-    vector<film> credits;
+    creditList credits;
     if (db.getCredits(response, credits)) return response;
     cout << "We couldn't find \"" << response << "\" in the movie database. "
 	 << "Please try again." << endl;
   }
 }
 
+/**
+ * The longest path (in movies) generateShortestPath looks for.
+ */
+
+static const int kMaxPathLength = 6;
+
 /** 
 *  Generates shortest path between 'start' actor and 'finish' actor if path exists,
-*  otherwise prints out that path couldn't be found.
+*  otherwise prints out that path couldn't be found.  The search itself is up to
+*  the actorGraph, which works with record offsets rather than names.
 */
-void generateShortestPath(const string& start, const string& finish, const imdb& db){
-  list<path> partialPaths;
-  set<string> previouslySeenActors;
-  set<film> previouslySeenFilms;
-
-  path partialPath(start);
-  partialPaths.push_front(partialPath);
-  while(!partialPaths.empty() && partialPaths.front().getLength() <= 5){
-    path front_path = partialPaths.front();
-    partialPaths.pop_front();
-    string last_player = front_path.getLastPlayer();
-    vector<film> movies;
-    db.getCredits(last_player, movies);
-    for(unsigned int i = 0; i < movies.size(); i++){
-      if(!previouslySeenFilms.count(movies[i])){
-        previouslySeenFilms.insert(movies[i]);
-        vector<string> cast;
-        db.getCast(movies[i], cast);
-        for(unsigned int j = 0; j < cast.size(); j++){
-          if(!previouslySeenActors.count(cast[j])){
-            previouslySeenActors.insert(cast[j]);
-            path clone = front_path;
-            clone.addConnection(movies[i], cast[j]);
-            if(cast[j] == finish){
-              cout << clone << endl;
-              return;
-            }else{
-              partialPaths.push_back(clone);
-            }
-          }
-        }
-      }
-    }
+void generateShortestPath(const string& start, const string& finish, actorGraph& graph){
+  path shortest(start);
+  if(graph.findShortestPath(start, finish, kMaxPathLength, shortest)){
+    cout << shortest << endl;
+  }else{
+    cout << "No path between those two people could be found." << endl;
   }
-  cout << "No path between those two people could be found." << endl;
 }
 
 /**
@@ -102,6 +81,7 @@ int main(int argc, const char *argv[])
     return 1;
   }
   
+  actorGraph graph(db);
   while (true) {
     string source = promptForActor("Actor or actress", db);
     if (source == "") break;
@@ -110,7 +90,7 @@ int main(int argc, const char *argv[])
     if (source == target) {
       cout << "Good one.  This is only interesting if you specify two different people." << endl;
     } else {
-      generateShortestPath(source, target, db);
+      generateShortestPath(source, target, graph);
     }
   }
   